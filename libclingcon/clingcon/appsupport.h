@@ -41,52 +41,127 @@
 #include <memory>
 #include <cstdint>
 #include <unordered_map>
+#include <mutex>
+#include <algorithm>
+#include <ostream>
+#include <vector>
 
 namespace clingcon
 {
 
+/// stores a propagator for each solver, indexed by the solver id
+/// does not take ownership, the propagators are owned by the solvers
+/// resize should be called with the number of solvers before solving,
+/// so that the list does not grow while other threads access it
+template <class Prop>
+class SolverRegistry
+{
+public:
+    /// returns nullptr if there is no propagator for solver id
+    Prop* get(unsigned int id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return id < props_.size() ? props_[id] : nullptr;
+    }
+
+    /// sets the propagator of solver id and returns the old one (or nullptr)
+    Prop* set(unsigned int id, Prop* p)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (id >= props_.size())
+            props_.resize(id+1, nullptr);
+        std::swap(props_[id], p);
+        return p;
+    }
+
+    /// makes room for numSolvers solvers
+    void resize(unsigned int numSolvers)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (numSolvers > props_.size())
+            props_.resize(numSolvers, nullptr);
+    }
+
+    /// number of solvers that have a slot, some of them may be nullptr
+    unsigned int size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return props_.size();
+    }
+
+    /// calls f(id, prop) for every solver that has a propagator
+    /// the registry must not be changed inside of f
+    template <class F>
+    void forEach(F f) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (unsigned int id = 0; id < props_.size(); ++id)
+            if (props_[id] != nullptr)
+                f(id, props_[id]);
+    }
+
+private:
+    std::vector<Prop*> props_;
+    mutable std::mutex mutex_;
+};
+
 class TheoryOutput : public Clasp::OutputTable::Theory
 {
 public:
-    TheoryOutput() { for (auto& i : props_) i = nullptr; }
+    TheoryOutput() : curr_(0), current_(nullptr) {}
+
+    /// sets the shown variables of the next solve step and computes the name table
+    void setNames(clingcon::NameList names)
+    {
+        names_ = std::move(names);
+        columns_.clear();
+        columns_.reserve(names_.size());
+        for (const auto& i : names_)
+            columns_.emplace_back(i.first);
+        std::sort(columns_.begin(), columns_.end());
+        columnNames_.clear();
+        columnNames_.reserve(columns_.size());
+        for (auto v : columns_)
+            columnNames_.emplace_back(names_.find(v)->second.first);
+    }
+
     //! Called once on new model m. Shall return 0 to indicate no output.
     virtual const char* first(const Clasp::Model& m)
     {
-        curr_ = names_.begin();
-        currentSolverId_ = m.sId;
+        curr_ = 0;
+        current_ = props_.get(m.sId);
+        assert(current_);
         return next();
     }
 
     //! Shall return 0 to indicate no output.
     virtual const char* next()
     {
-        while (curr_ != names_.end())
+        while (curr_ != columns_.size())
         {
-            const char* ret = props_[currentSolverId_]->printModel(curr_->first,curr_->second.first);
-            if (ret)
-            {
-            ++curr_;
-            return ret;
-            }
+            const char* ret = current_->printModel(curr_,columnNames_[curr_]);
             ++curr_;
+            if (ret)
+                return ret;
         }
         return 0;
     }
 
     bool first(const Clasp::Model& m, const char*& name, int32& value)
     {
-        curr_ = names_.begin();
-        currentSolverId_ = m.sId;
+        curr_ = 0;
+        current_ = props_.get(m.sId);
+        assert(current_);
         return next(name,value);
     }
 
     bool next(const char*& name, int32& value)
     {
-        while (curr_ != names_.end())
+        while (curr_ != columns_.size())
         {
-            if (props_[currentSolverId_]->getValue(curr_->first,value))
+            if (current_->getValue(curr_,value))
             {
-                name = curr_->second.first.c_str();
+                name = columnNames_[curr_].c_str();
                 ++curr_;
                 return true;
             }
@@ -95,11 +170,21 @@ public:
         return false;
     }
 
-    clingcon::NameList::iterator curr_;
-    unsigned int currentSolverId_;
+    /// columnar output, the name table is fixed for a solve step,
+    /// every model is a row with one int32 value per column
+    const std::vector<order::Variable>& columns() const { return columns_; }
+    const std::vector<std::string>& columnNames() const { return columnNames_; }
+    /// the values of model m, owned by the propagator of its solver and valid until it finds the next model
+    /// a value is only meaningful if the column is defined in m
+    const std::vector<int32>& row(const Clasp::Model& m) const { return props_.get(m.sId)->modelValues(); }
+    const std::vector<bool>& defined(const Clasp::Model& m) const { return props_.get(m.sId)->modelDefined(); }
+
+    std::size_t curr_; /// column of the next value to print
+    clingcon::ClingconOrderPropagator* current_; /// propagator of the solver that found the current model
     clingcon::NameList names_; /// order::Variable to name + condition
-    static const int numThreads = 64;
-    clingcon::ClingconOrderPropagator* props_[numThreads];
+    std::vector<order::Variable> columns_; /// the shown variables in increasing order, shared with the propagators
+    std::vector<std::string> columnNames_; /// name of every column
+    SolverRegistry<clingcon::ClingconOrderPropagator> props_;
 
 };
 
@@ -112,13 +197,38 @@ public:
 
     ~Configurator()
     {
-        for (unsigned int i = 0; i < to_.numThreads; ++i)
-            if (to_.props_[i] != nullptr)
-            {
-                to_.props_[i]->solver().removePost(to_.props_[i]);
-                delete to_.props_[i];
-                to_.props_[i] = nullptr;
-            }
+        removeProps();
+        proxies_.forEach([](unsigned int, clingcon::OrderWatchProxy* p) { delete p; });
+    }
+
+    /// removes the propagators from all solvers and deletes them
+    void removeProps()
+    {
+        resetWatches();
+        for (unsigned int i = 0, end = to_.props_.size(); i < end; ++i)
+            removeOrderProp(to_.props_.set(i,nullptr));
+        for (unsigned int i = 0, end = dlprops_.size(); i < end; ++i)
+            removePost(dlprops_.set(i,nullptr));
+    }
+
+    /// suspends the order propagators of the first numSolvers solvers between two solve steps,
+    /// so that they can be extended in the next step, all other propagators are removed
+    /// the propagators are ordered by the difference logic option, so they are always recreated with it
+    void suspendProps(unsigned int numSolvers)
+    {
+        resetWatches();
+        for (unsigned int i = 0, end = to_.props_.size(); i < end; ++i)
+        {
+            clingcon::ClingconOrderPropagator* p = to_.props_.get(i);
+            if (p == nullptr)
+                continue;
+            if (i < numSolvers && conf_.dlprop==0)
+                p->suspend();
+            else
+                removeOrderProp(to_.props_.set(i,nullptr));
+        }
+        for (unsigned int i = 0, end = dlprops_.size(); i < end; ++i)
+            removePost(dlprops_.set(i,nullptr));
     }
 
     virtual bool addPost(Clasp::Solver& s)
@@ -127,57 +237,121 @@ public:
         /// here is the latest point to get the actual view
         if (!n_.getVariableCreator().restrictDomainsAccordingToLiterals())
             return false;
-        //if (conf_.dlprop==2)
-        //    if (!addDLProp(s,n_.constraints()))
-        //        return false;
+        removePost(dlprops_.set(s.id(),nullptr));
+        /// incremental solving, only the new constraints and variables are added to the old propagator
+        clingcon::ClingconOrderPropagator* old = to_.props_.get(s.id());
+        if (old != nullptr && old->suspended() && &old->solver()==&s &&
+            old->extend(n_.getVariableCreator(),n_.sharedConstraints(),n_.sharedDistincts(),n_.sharedDisjoints()))
+            return old->resume();
+        removeOrderProp(to_.props_.set(s.id(),nullptr));
+        if (conf_.dlprop==1)
+            if (!addDLProp(s))
+                return false;
+
+        ///solver takes ownership of propagator
+        clingcon::ClingconOrderPropagator* test = new clingcon::ClingconOrderPropagator(s, n_.getVariableCreator(), conf_,
+                                                                                      n_.sharedConstraints(),n_.sharedDistincts(),n_.sharedDisjoints(),n_.getEqualities(),
+                                                                                      &(to_.names_), &(to_.columns_),
+                                                                                      s.id() < conf_.convertLazy.first || n_.lazyLiterals().poolSize() ? &n_.lazyLiterals() : nullptr,
+                                                                                      conf_.translateHot.first != 0 ? &n_.constraintActivity() : nullptr,
+                                                                                      proxy(s.id()), orderWatches());
+        to_.props_.set(s.id(),test);
+        if (!s.addPost(test))
+           return false;
+
+        if (conf_.dlprop==2)
+            if (!addDLProp(s))
+                return false;
+        return true;
+    }
 
+    /// the queue statistics of all order propagators, including the removed ones
+    order::QueueStats queueStats() const
+    {
+        order::QueueStats ret = removedStats_;
+        to_.props_.forEach([&ret](unsigned int, clingcon::ClingconOrderPropagator* p) { ret += p->queueStats(); });
+        return ret;
+    }
 
-        if (to_.props_[s.id()])
+private:
+    /// adds a difference logic propagator for all constraints of the form x-y<=k
+    /// the order propagator still gets all constraints
+    bool addDLProp(Clasp::Solver& s)
+    {
+        clingcon::ClingconDLPropagator* dlp = new clingcon::ClingconDLPropagator(s, conf_);
+        for (const auto&i : *n_.sharedConstraints())
         {
-            s.removePost(to_.props_[s.id()]);
-            delete to_.props_[s.id()];
-            to_.props_[s.id()] = nullptr;
+            if (dlp->isValidConstraint(i))
+                dlp->addValidConstraint(i);
         }
+        if (dlp->numEdges()==0)
+        {
+            delete dlp;
+            return true;
+        }
+        dlprops_.set(s.id(),dlp);
+        return s.addPost(dlp);
+    }
 
+    /// the proxy for the order literal watches of solver id, it is kept until the configurator is destroyed,
+    /// as stale watches of deleted propagators can still refer to it
+    clingcon::OrderWatchProxy* proxy(unsigned int id)
+    {
+        clingcon::OrderWatchProxy* p = proxies_.get(id);
+        if (p == nullptr)
+        {
+            p = new clingcon::OrderWatchProxy();
+            proxies_.set(id,p);
+        }
+        return p;
+    }
 
-        //std::vector<order::ReifiedLinearConstraint> constraints;
-        //if (conf_.dlprop==1)
-        //{
-        //    constraints = n_.constraints();
-        //}
+    /// the order literals to watch in this solve step, computed by the first solver and shared with the others
+    std::shared_ptr<const clingcon::OrderWatches> orderWatches()
+    {
+        std::lock_guard<std::mutex> lock(watchesMutex_);
+        if (!watches_ || !watches_->fits(n_.getVariableCreator(),n_.sharedConstraints(),n_.sharedDistincts(),n_.sharedDisjoints()))
+            watches_ = std::make_shared<const clingcon::OrderWatches>(n_.getVariableCreator(),conf_,
+                                                                      n_.sharedConstraints(),n_.sharedDistincts(),n_.sharedDisjoints(),
+                                                                      &(to_.names_),n_.getEqualities());
+        return watches_;
+    }
 
-        ///solver takes ownership of propagator
-        clingcon::ClingconOrderPropagator* test = new clingcon::ClingconOrderPropagator(s, n_.getVariableCreator(), conf_,
-                                                                                      n_.constraints(),n_.getEqualities(),
-                                                                                      &(to_.names_));
-        to_.props_[s.id()] = test;
-        if (!s.addPost(to_.props_[s.id()]))
-           return false;
+    /// the literals can change between two solve steps without changing the constraints
+    void resetWatches()
+    {
+        std::lock_guard<std::mutex> lock(watchesMutex_);
+        watches_.reset();
+    }
 
-//        if (conf_.dlprop==1)
-//            if (!addDLProp(s, constraints))
-//                return false;
-        return true;
+    /// keeps the statistics of p and removes it
+    void removeOrderProp(clingcon::ClingconOrderPropagator* p)
+    {
+        if (p != nullptr)
+            removedStats_ += p->queueStats();
+        removePost(p);
     }
 
-private:
-//    bool addDLProp(Clasp::Solver& s, const std::vector<order::ReifiedLinearConstraint>& constraints)
-//    {
-//        clingcon::ClingconDLPropagator* dlp = new clingcon::ClingconDLPropagator(s, conf_);
-//        for (const auto&i : constraints)
-//        {
-//            if (dlp->isValidConstraint(i))
-//                dlp->addValidConstraint(i);
-//        }
-//        if (!s.addPost(dlp))
-//            return false;
-//        return true;
-//    }
+    /// removes p from its solver and deletes it
+    template <class Prop>
+    static void removePost(Prop* p)
+    {
+        if (p != nullptr)
+        {
+            p->solver().removePost(p);
+            delete p;
+        }
+    }
 
     order::Config conf_;
     order::Normalizer& n_;
     TheoryOutput& to_;
     clingcon::ClingconOrderPropagator* cp_;
+    SolverRegistry<clingcon::ClingconDLPropagator> dlprops_;
+    SolverRegistry<clingcon::OrderWatchProxy> proxies_; /// owned by the configurator
+    std::shared_ptr<const clingcon::OrderWatches> watches_;
+    std::mutex watchesMutex_;
+    order::QueueStats removedStats_; /// statistics of the deleted order propagators
 };
 
 
@@ -189,7 +363,11 @@ public:
 
     void postRead();
     bool postEnd();
-    void postSolve();
+    /// converts the lazy literals and translates the hot constraints after a solve step,
+    /// returns false if this made the problem unsatisfiable, the next step then starts with a conflict
+    bool postSolve();
+    /// prints the propagation queue statistics of all solvers
+    void printStatistics(std::ostream& out) const;
 
     TheoryOutput* theoryOutput() { return &to_; }
 
@@ -212,6 +390,7 @@ private:
     clingcon::TheoryParser tp_;
 
     std::vector<order::Direction> tdinfo_;
+    bool unsat_; /// set by postSolve if the constraints are unsatisfiable in all further steps
 
 
 
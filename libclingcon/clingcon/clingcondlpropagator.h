@@ -22,27 +22,28 @@
 
 // }}}
 
-/*#pragma once
+#pragma once
 #include <clasp/constraint.h>
 #include <order/dlpropagator.h>
 #include <order/constraint.h>
 #include <order/config.h>
 
-
-//#include <memory>
-//#include <cstdint>
 #include <unordered_map>
 
 
 namespace clingcon
 {
 
+/// propagates all constraints of the form v -> x - y <= k
+/// with incremental negative cycle detection
+/// the constraints are still handled by the order propagator,
+/// which is needed for the domains and the values of the variables
 class ClingconDLPropagator : public Clasp::PostPropagator
 {
 public:
 
     ClingconDLPropagator(Clasp::Solver& s, order::Config conf) :
-        s_(s), conf_(conf), propagated_pointer_(0)
+        s_(s), conf_(conf)
     {
         activationsPerDl_.emplace_back(0);
         dls_.emplace_back(0);
@@ -56,51 +57,40 @@ public:
     void addValidConstraint(const order::ReifiedLinearConstraint &rl);
 
     /// propagator interface
-    virtual uint32 priority() const { return Clasp::PostPropagator::priority_reserved_ufs+1; }
-    virtual bool   init(Clasp::Solver& s);
-    virtual bool   propagateFixpoint(Clasp::Solver& , Clasp::PostPropagator* );
-    virtual void   reset();
-    virtual bool   isModel(Clasp::Solver& s);
+    virtual uint32 priority() const override { return Clasp::PostPropagator::priority_reserved_ufs+1; }
+    virtual bool   init(Clasp::Solver& s) override;
+    virtual bool   propagateFixpoint(Clasp::Solver& , Clasp::PostPropagator* ) override;
+    virtual void   reset() override;
+    virtual bool   isModel(Clasp::Solver& s) override;
 
     /// constraint interface
-    virtual PropResult propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data);
-    virtual void reason(Clasp::Solver& s, Clasp::Literal p, Clasp::LitVec& lits);
-    virtual void undoLevel(Clasp::Solver& s);
-    virtual bool simplify(Clasp::Solver& , bool) { return false; }
-
-    ///TODO!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!! DESTROY MUSS ÜBERLADEN WERDEN, und watches removed
-
-    //! Returns an estimate of the constraint's complexity relative to a clause (complexity = 1).
-    /// currently not used in clasp propagators
-
+    virtual PropResult propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data) override;
+    virtual void reason(Clasp::Solver& s, Clasp::Literal p, Clasp::LitVec& lits) override;
+    virtual void undoLevel(Clasp::Solver& s) override;
+    virtual bool simplify(Clasp::Solver& , bool) override { return false; }
 
+    Clasp::Solver& solver() { return s_; }
+    std::size_t numEdges() const { return literals_.size(); }
 
 private:
 
-
-
+    /// EdgeId>0 -> literals_[id-1], EdgeId<0 -> ~(literals_[-id-1])
     Clasp::Literal edgeid2lit(difflogic::DLPropagator::EdgeId id) const;
-    //ClingconDLPropagator::LitEdge litIndex2ledge(const Clasp::Literal& l) const; /// warning, this does not take a literal, but a data blob
-
+    /// forces the negated literal of the false edge -id
+    bool forceFalse(difflogic::DLPropagator::EdgeId id);
 
 
     Clasp::Solver& s_;
     order::Config conf_;
-    Clasp::LitVec literals_; // EdgeId>0 -> literals_[id-1], EdgeId<0 -> ~(literals_[-id-1])
-    Clasp::LitVec propagated_; /// i propagated these myself
-    unsigned int propagated_pointer_; /// a pointer to the yet unchecked part of the propagated_ list
-    /// all these things should be on the watch stack in the same order
-    /// but may be interleaved with some others
+    Clasp::LitVec literals_; /// literal of each edge
     std::vector<difflogic::DLPropagator::EdgeId> pending_; /// a list of EdgeId's that are pending to be propagated by us
 
     std::vector<unsigned int> activationsPerDl_; /// the number of activations per decision level
     std::vector<unsigned int> dls_;
-    //std::unordered_map<difflogic::DLPropagator::InternalEdge, Clasp::Literal, difflogic::DLPropagator::Edgehash> edge2Lit_;
-    //std::unique_ptr<order::IncrementalSolver> ms_;
+    std::unordered_map<Clasp::Var, difflogic::DLPropagator::EdgeId> reasons_; /// for every variable i forced, the negated id of the false edge
     difflogic::DLPropagator p_;
 
 };
 
 
 }
-*/
@@ -30,6 +30,7 @@
 #include <clingcon/theoryparser.h>
 #include <memory>
 #include <cstdint>
+#include <limits>
 #include <unordered_map>
 
 
@@ -48,6 +49,230 @@ namespace clingcon
 {
 
 
+/// maps Clasp variables to the csp variables + bounds they represent
+/// the entries known at construction time are stored contiguously (compressed sparse row),
+/// entries for literals that are created during search go into an overflow area
+/// that is chained per variable, so a lookup never needs to hash
+/// the contiguous part can be shared between several indices, the overflow area is always private
+class OrderWatchIndex
+{
+public:
+    /// csp variable with signed bound, see ClingconOrderPropagator::addWatch
+    using Entry = std::pair<order::Variable, int32>;
+
+    OrderWatchIndex() : built_(false) {}
+
+    /// adds an entry for Clasp variable v
+    /// before build() the entry is part of the static index, afterwards it goes into the overflow area
+    void add(Clasp::Var v, const Entry& e)
+    {
+        if (!built_)
+        {
+            pending_.emplace_back(v,e);
+            return;
+        }
+        if (v >= overflowHead_.size())
+        {
+            overflowHead_.resize(v+1,npos);
+            overflowTail_.resize(v+1,npos);
+        }
+        uint32 index = overflow_.size();
+        overflow_.emplace_back(e,npos);
+        if (overflowHead_[v]==npos)
+            overflowHead_[v] = index;
+        else
+            overflow_[overflowTail_[v]].second = index;
+        overflowTail_[v] = index;
+    }
+
+    /// sort all previously added entries into one contiguous array
+    void build()
+    {
+        assert(!built_);
+        Clasp::Var maxVar = 0;
+        for (const auto& i : pending_)
+            maxVar = std::max(maxVar,i.first);
+        std::shared_ptr<Table> table = std::make_shared<Table>();
+        table->start.assign(pending_.size() ? maxVar+2 : 1,0);
+        for (const auto& i : pending_)
+            ++table->start[i.first+1];
+        for (std::size_t i = 1; i < table->start.size(); ++i)
+            table->start[i] += table->start[i-1];
+        table->entries.resize(pending_.size());
+        std::vector<uint32> insert(table->start.begin(),table->start.end()-1);
+        for (const auto& i : pending_)
+            table->entries[insert[i.first]++] = i.second;
+        pending_.clear();
+        pending_.shrink_to_fit();
+        table_ = table;
+        built_ = true;
+    }
+
+    /// uses the contiguous array of other, which is shared and never changed
+    /// pre: other is built and no entries have been added to this index
+    void build(const OrderWatchIndex& other)
+    {
+        assert(!built_ && pending_.empty() && other.built_);
+        table_ = other.table_;
+        built_ = true;
+    }
+
+    /// moves the entries of the contiguous array back into the pending ones,
+    /// so that entries can be added before build() is called again,
+    /// the overflow area is dropped
+    void reopen()
+    {
+        assert(built_);
+        pending_.clear();
+        pending_.reserve(table_->entries.size());
+        for (Clasp::Var v = 0; v+1 < table_->start.size(); ++v)
+            for (uint32 i = table_->start[v]; i != table_->start[v+1]; ++i)
+                pending_.emplace_back(v,table_->entries[i]);
+        table_.reset();
+        overflowHead_.clear();
+        overflowTail_.clear();
+        overflow_.clear();
+        built_ = false;
+    }
+
+    class const_iterator : public std::iterator<std::forward_iterator_tag, Entry>
+    {
+    public:
+        const_iterator(const OrderWatchIndex& index, uint32 pos, uint32 end, uint32 overflow) :
+            index_(&index), pos_(pos), end_(end), overflow_(overflow) {}
+        bool operator==(const const_iterator& x) const { return pos_==x.pos_ && overflow_==x.overflow_; }
+        bool operator!=(const const_iterator& x) const { return !(*this==x); }
+        const Entry& operator*() const { return pos_ < end_ ? index_->table_->entries[pos_] : index_->overflow_[overflow_].first; }
+        const Entry* operator->() const { return &(**this); }
+        const_iterator& operator++()
+        {
+            if (pos_ < end_)
+                ++pos_;
+            else
+                overflow_ = index_->overflow_[overflow_].second;
+            return *this;
+        }
+    private:
+        const OrderWatchIndex* index_;
+        uint32 pos_;
+        uint32 end_;
+        uint32 overflow_;
+    };
+
+    struct Range
+    {
+        const_iterator begin() const { return b; }
+        const_iterator end() const { return e; }
+        const_iterator b;
+        const_iterator e;
+    };
+
+    /// all entries for Clasp variable v
+    /// pre: build()
+    Range find(Clasp::Var v) const
+    {
+        assert(built_);
+        uint32 pos = 0, end = 0;
+        if (v+1 < table_->start.size())
+        {
+            pos = table_->start[v];
+            end = table_->start[v+1];
+        }
+        uint32 overflow = v < overflowHead_.size() ? overflowHead_[v] : npos;
+        return Range{const_iterator(*this,pos,end,overflow),const_iterator(*this,end,end,npos)};
+    }
+
+    bool contains(Clasp::Var v) const { auto r = find(v); return r.begin()!=r.end(); }
+
+private:
+    enum : uint32 { npos = std::numeric_limits<uint32>::max() };
+    struct Table
+    {
+        std::vector<uint32> start;                      /// Clasp::Var -> first index in entries
+        std::vector<Entry> entries;                     /// static entries, grouped by Clasp::Var
+    };
+    bool built_;
+    std::vector<std::pair<Clasp::Var,Entry> > pending_; /// entries added before build
+    std::shared_ptr<const Table> table_;                /// can be shared by the propagators of several solvers
+    std::vector<uint32> overflowHead_;                  /// Clasp::Var -> first index in overflow_
+    std::vector<uint32> overflowTail_;                  /// Clasp::Var -> last index in overflow_
+    std::vector<std::pair<Entry,uint32> > overflow_;    /// entries added after build, with index of next entry
+};
+
+
+/// the order literals that the propagators of one solve step have to watch,
+/// computed once from the shared variables and constraints and then used read only by the propagators of all solvers,
+/// each of them registers its watches in one pass over literals() and shares the contiguous watch index
+/// the variables of shown variables are watched as well, so that their values are known in every model without searching
+class OrderWatches
+{
+public:
+    OrderWatches(const order::VariableCreator& vc, const order::Config& conf,
+                 const order::SharedConstraints& constraints, const order::SharedDistincts& distincts,
+                 const order::SharedDisjoints& disjoints, const NameList* names,
+                 const order::EqualityProcessor::EqualityClassMap& equalities);
+
+    /// true if the watches have been computed for these constraints and domains
+    bool fits(const order::VariableCreator& vc, const order::SharedConstraints& constraints,
+              const order::SharedDistincts& distincts, const order::SharedDisjoints& disjoints) const;
+
+    /// the csp variables whose order literals are watched
+    const std::vector<bool>& watched() const { return watched_; }
+    /// every watched order literal, once per Clasp variable, to be watched with both signs
+    const std::vector<Clasp::Literal>& literals() const { return literals_; }
+    /// Clasp variables to csp variables + bounds, see ClingconOrderPropagator::addWatch
+    const OrderWatchIndex& index() const { return index_; }
+    /// size of the domain of every variable, 0 if invalid
+    const std::vector<uint64>& domainSizes() const { return domainSizes_; }
+
+private:
+    const order::SharedConstraints::element_type* constraints_;
+    const order::SharedDistincts::element_type* distincts_;
+    const order::SharedDisjoints::element_type* disjoints_;
+    std::vector<bool> watched_;
+    std::vector<Clasp::Literal> literals_;
+    OrderWatchIndex index_;
+    std::vector<uint64> domainSizes_;
+};
+
+
+class ClingconOrderPropagator;
+
+/// receives the order literal watches of the propagators of one solver and forwards them to the current one,
+/// every propagator starts a new generation that is stored in the watch data,
+/// so destroying a propagator does not need to remove its watches one by one,
+/// they are dropped by clasp the next time they are triggered
+/// has to live as long as the watches in its solver, so it is never deleted before the solver
+class OrderWatchProxy : public Clasp::Constraint
+{
+public:
+    OrderWatchProxy() : target_(nullptr), generation_(0) {}
+
+    /// forwards all watches of the new generation to p and returns the generation
+    uint32 attach(ClingconOrderPropagator* p)
+    {
+        generation_ = generation_ == maxGeneration ? 1 : generation_+1;
+        target_ = p;
+        return generation_;
+    }
+    /// all watches of p become stale
+    void detach(const ClingconOrderPropagator* p)
+    {
+        if (target_ == p)
+            target_ = nullptr;
+    }
+
+    virtual PropResult propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data) override;
+    virtual void reason(Clasp::Solver& , Clasp::Literal , Clasp::LitVec& ) override { assert(false); }
+    virtual Clasp::Constraint* cloneAttach(Clasp::Solver& ) override { return nullptr; }
+
+private:
+    enum : uint32 { maxGeneration = (1u<<30)-1 }; /// has to fit into the variable of a DataBlob
+    ClingconOrderPropagator* target_;
+    uint32 generation_;
+};
+
+
 ///sign of the literal, for order literals a positive literal is alsways a <= x, while a negative one is a > x
 class ClingconOrderPropagator : public Clasp::PostPropagator
 {
@@ -56,9 +281,15 @@ public:
     using DataBlob = Clasp::Literal;
 
     ClingconOrderPropagator(Clasp::Solver& s, const order::VariableCreator& vc, const order::Config& conf,
-                       const std::vector<order::ReifiedLinearConstraint>& constraints, const order::EqualityProcessor::EqualityClassMap& equalities,
-                            const NameList* names) :
-        s_(s), conf_(conf), ms_(new MyLocalSolver(s)), p_(*(ms_.get()), vc, conf), eqs_(equalities), dls_{0}, assertConflict_(false), names_(names)
+                       const order::SharedConstraints& constraints, const order::SharedDistincts& distincts,
+                            const order::SharedDisjoints& disjoints, const order::EqualityProcessor::EqualityClassMap& equalities,
+                            const NameList* names, const std::vector<order::Variable>* shown = nullptr,
+                            order::LazyLiteralRegistry* lazyLits = nullptr,
+                            order::ConstraintActivity* activity = nullptr, OrderWatchProxy* proxy = nullptr,
+                            std::shared_ptr<const OrderWatches> watches = nullptr) :
+        s_(s), conf_(conf), ms_(new MyLocalSolver(s)), p_(*(ms_.get()), vc, conf), eqs_(equalities), dls_{0}, assertConflict_(false), inConflict_(false), names_(names), shown_(shown),
+        lazyLits_(lazyLits), activity_(activity), suspended_(false), proxy_(proxy),
+        watchTarget_(proxy ? static_cast<Clasp::Constraint*>(proxy) : this), generation_(proxy ? proxy->attach(this) : 0)
     {
         if (s_.hasConflict())
             return;
@@ -89,55 +320,26 @@ public:
         ///
         ///
 
-        watched_.resize(p_.getVVS().getVariableStorage().numVariables(),false);
-
-        /// add watches for undecided reification literals
-        for (std::size_t cindex = 0; cindex < constraints.size(); ++cindex)
-        {
-            for (auto view : constraints[cindex].l.getConstViews())
-            {
-                watched_[view.v]=true;
-            }
-            /// just watch the nonfalse ones
-            Clasp::Literal l = toClaspFormat(constraints[cindex].v);
-            if (!s.isFalse(l)) /// permanent false otherwise, do not need to consider it
-            {
-                DataBlob blob(cindex,false);
-                s.addWatch(l, this, blob.rep());
-                //s.addWatch(~l, this, blob.asUint()); // i'm just watching implications
-            }
-        }
-
-
-        /// add watches for the order literals
-        for (std::size_t var = 0; var != vc.numVariables(); ++var)
-        {
-            if (vc.isValid(var))
-            {
-                if (!conf.explicitBinaryOrderClausesIfPossible)
-                    watched_[var]=true;
-                else
-                if (p_.getVVS().getVariableStorage().getOrderStorage(var).numLits() < p_.getVVS().getVariableStorage().getDomain(var).size())
-                    watched_[var]=true;
-            }
-        }
-
-        for (std::size_t var = 0; var != watched_.size(); ++var)
+        p_.addImp(constraints);
+        p_.addDistincts(distincts);
+        p_.addDisjoints(disjoints);
+
+        /// the order literals are usually computed once for all solvers
+        if (!watches || !watches->fits(vc, constraints, distincts, disjoints))
+            watches = std::make_shared<const OrderWatches>(vc, conf, constraints, distincts, disjoints, names, equalities);
+        watched_ = watches->watched();
+        watchConstraints(0);
+        watchGlobals();
+        DataBlob blob(generation_, true);
+        for (Clasp::Literal l : watches->literals())
         {
-            if (watched_[var])
-            {
-                auto lr = order::pure_LELiteral_iterator(vc.getRestrictor(order::View(var)).begin(), p_.getVVS().getVariableStorage().getOrderStorage(var), true);
-
-                while(lr.isValid())
-                {
-                    ///TODO: do i need to do this for true lits ?
-                    addWatch((order::Variable)(var),toClaspFormat(*lr),lr.numElement());
-                    ++lr;
-                }
-            }
+            s_.addWatch(l, watchTarget_, blob.rep());
+            s_.addWatch(~l, watchTarget_, blob.rep());
         }
-
-        p_.addImp(constraints);
+        watchIndex_.build(watches->index());
+        domainSizes_ = watches->domainSizes();
+        collectSplitCandidates();
+        collectColumns();
     }
     virtual ~ClingconOrderPropagator()
     {
@@ -148,24 +350,65 @@ public:
                 s_.removeWatch(toClaspFormat(p_.constraints()[cindex].v),this);
             }
         }
+        for (const auto& d : p_.distincts())
+        {
+            if (s_.hasWatch(toClaspFormat(d.getLiteral()),this))
+                s_.removeWatch(toClaspFormat(d.getLiteral()),this);
+        }
+        for (const auto& d : p_.disjoints())
+        {
+            if (s_.hasWatch(toClaspFormat(d.getLiteral()),this))
+                s_.removeWatch(toClaspFormat(d.getLiteral()),this);
+            for (const auto& group : d.getViews())
+                for (const auto& i : group)
+                    if (s_.hasWatch(toClaspFormat(i.second),this))
+                        s_.removeWatch(toClaspFormat(i.second),this);
+        }
 
+        /// the watches of the order literals become stale at once
+        if (proxy_)
+        {
+            proxy_->detach(this);
+            return;
+        }
+        /// the order storages are iterated directly, the domains may already have changed
+        /// if the propagator was suspended
         for (std::size_t var = 0; var != watched_.size(); ++var)
         {
-            if (watched_[var])
+            if (watched_[var] && p_.getVVS().getVariableStorage().isValid(var))
             {
-                auto lr = order::pure_LELiteral_iterator(p_.getVVS().getVariableStorage().getRestrictor(order::View(var)).begin(), p_.getVVS().getVariableStorage().getOrderStorage(var), true);
-                while(lr.isValid())
+                p_.getVVS().getStorage(var).forEach([&](unsigned int, order::Literal l)
                 {
-                    s_.removeWatch(toClaspFormat(*lr), this);
-                    s_.removeWatch(toClaspFormat(~(*lr)), this);
-                    ++lr;
-                }
+                    if (s_.validVar(toClaspFormat(l).var()))
+                    {
+                        s_.removeWatch(toClaspFormat(l), this);
+                        s_.removeWatch(toClaspFormat(~l), this);
+                    }
+                });
             }
-
-
         }
     }
 
+    /// stops propagating until the propagator is extended for the next solve step,
+    /// the literals that get true in the meantime are remembered and propagated afterwards
+    /// pre: on the top level
+    void suspend() { suspended_ = true; }
+    bool suspended() const { return suspended_; }
+
+    /// incremental solving: adds the constraints and variables of the next solve step,
+    /// constraints must start with the linear constraints of this propagator,
+    /// only the new constraints, variables and order literals get watched
+    /// returns false if the propagator can not be extended, e.g. because
+    /// the domains of the old variables changed, it has to be recreated in this case
+    /// pre: suspended()
+    bool extend(const order::VariableCreator& vc, const order::SharedConstraints& constraints,
+                const order::SharedDistincts& distincts, const order::SharedDisjoints& disjoints);
+
+    /// propagates the literals that got true while the propagator was suspended
+    /// returns false on conflict
+    /// pre: extend returned true
+    bool resume();
+
     /// propagator interface
     virtual uint32 priority() const override { return Clasp::PostPropagator::priority_reserved_ufs+1; } // we schedule after the ufs checker
     virtual bool   init(Clasp::Solver &s) override;
@@ -189,19 +432,57 @@ public:
     ///virtual uint32 estimateComplexity(const Clasp::Solver& s) const { return 42; /* do some rought guessing by the number of constraints/size*/}
 
 
-    const char* printModel(order::Variable v, const std::string& name);
+    /// name=value of the shown variable in column of the last model, 0 if it is not shown in this model
+    const char* printModel(std::size_t column, const std::string& name);
     /// only to be used of a model has been found
-    bool getValue(order::Variable v, int32& value);
+    bool getValue(std::size_t column, int32& value);
+    /// the values of the shown variables in the last model, one per column,
+    /// a value is only meaningful if the column is defined in the model
+    const std::vector<int32>& modelValues() const { return modelValues_; }
+    const std::vector<bool>& modelDefined() const { return modelDefined_; }
+    /// the position in a current domain of size elements whose literal var<=element is created by splitting at h,
+    /// see Config::splitVariables
+    /// pre: size>1
+    static std::size_t splitPoint(std::size_t size, unsigned int h);
 
     Clasp::Solver& solver() { return s_; }
 
 
     const order::VolatileVariableStorage& getVVS() const { return p_.getVVS(); }
+    const order::QueueStats& queueStats() const { return p_.stats(); }
 
 private:
     /// add a watch for var<=a for iterator it
     /// step is the precalculated number of it-getLiteralRestrictor(var).begin()
     void addWatch(const order::Variable& var, const Clasp::Literal &cl, unsigned int step);
+    /// watches the reification literals of the linear constraints from cindex on
+    /// and marks their variables as watched
+    void watchConstraints(std::size_t cindex);
+    /// watches the literals of the alldistinct and disjoint constraints and marks their variables,
+    /// they are numbered after the linear constraints
+    void watchGlobals();
+    /// true if the order literals of var have to be watched even if no constraint uses it
+    bool needsOrderWatches(order::Variable var) const;
+    /// marks the variables of the shown variables as watched, so that their current domain is always known
+    void watchShown();
+    /// watches all order literals of var
+    void watchOrderLiterals(order::Variable var);
+    /// remembers the domain sizes of all variables, to detect domain changes between solve steps
+    void storeDomainSizes();
+    /// the valid watched variables that can lack order literals, they have to be decided for a model
+    void collectSplitCandidates();
+    /// creates a new order literal inside the current domain of var, see Config::splitVariables
+    void split(order::Variable var);
+    /// watches a literal for var<=domain[index], which has none yet, and returns it,
+    /// the shared one of lazyLits_ if it is still free in this solver, otherwise a new local one
+    order::Literal createLELiteral(order::Variable var, unsigned int index);
+    /// closes the pool of lazyLits_ and adds a conflicting clause if a pool literal
+    /// disagrees with the bound it stands for, or is true without standing for one
+    /// returns false in this case
+    /// pre: all watched variables are decided
+    bool checkSharedLiterals();
+    /// the columns of the shown variables, with the variables and edges their values are computed from
+    void collectColumns();
     ///debug function
     bool orderLitsAreOK();
     Clasp::Solver& s_;
@@ -217,29 +498,67 @@ private:
     /// where eps is the next valid literal
     void forceKnownLiteralLE(order::ViewIterator it, Clasp::Literal l);
     void forceKnownLiteralGE(order::ViewIterator it, Clasp::Literal l);
+    /// return the literal x>=*it, creates it if it does not exist yet
+    /// if it is free but implied by the current bounds, it is forced
+    Clasp::Literal getGELiteral(const order::ViewIterator& it);
 
     /// for each Clasp Variable there is a vector of csp Variables with bounds
     /// For each CSP Variable there is an int x
     /// abs(x)-1: steps from the lowest element of the variable to the actual value that is referenced
     /// sign(x): positive if literal without sign means v <= y, negative if literal with sign means v <= y
-    std::unordered_map<Clasp::Var, std::vector<std::pair<order::Variable, int32> > > propVar2cspVar_;/// Clasp Literals to csp variables+bound
+    OrderWatchIndex watchIndex_; /// Clasp Literals to csp variables+bound
     //const std::vector<std::unique_ptr<order::LitVec> >& var2OrderLits_; /// CSP variables to Clasp::order
 
     std::vector<std::size_t> dls_; /// every decision level that we are registered for
 
     bool assertConflict_;
 
-    std::unordered_map<Clasp::Var, Clasp::LitVec> reasons_; /// for every variable i store a reason if i have to give it,
+    /// a clause propagated without learning it, given by the constraint
+    /// and the bounds of its views, stored in reasonPool_[offset...offset+#views),
+    /// or by its literals, stored in reasonPool_[offset...offset+literals) if literals is not 0
+    struct ReasonRecord
+    {
+        ReasonRecord(std::size_t constraint = 0, std::size_t offset = 0) : constraint(constraint), offset(offset), literals(0) {}
+        std::size_t constraint;
+        std::size_t offset;
+        std::size_t literals;
+    };
+    std::unordered_map<Clasp::Var, ReasonRecord> reasons_; /// for every variable i store a reason if i have to give it,
                                                             /// can contain reasons that are no longer valid (does not shrink)
-    Clasp::LitVec conflict_;                               /// only set in imediate conflict in addition to reasons,
+    ReasonRecord conflict_;                                 /// only set in imediate conflict in addition to reasons,
                                                             /// as reason can already be set for this variable (opposite sign)
+    bool inConflict_;
+    std::vector<uint64> reasonPool_;                        /// indices of the bounds of the views or literals for all records
+    std::vector<std::size_t> poolMarks_;                    /// size of reasonPool_ for every decision level in dls_, except the first
 
     std::vector<std::string> show_; /// order::Variable -> string name
     std::string outputbuf_;
     std::vector<bool> watched_; /// which variables we need to watch
+    std::vector<order::Variable> splitCandidates_; /// the watched variables that may have to be split
+    std::vector<std::pair<uint64,order::Variable> > undecided_; /// current domain sizes of the undecided variables in isModel
 
-    std::unordered_map<order::Variable,int32> lastModel_; /// values of all shown variables in the last model
+    struct Column
+    {
+        order::Variable shown;             /// the shown variable
+        order::Variable var;               /// the variable holding its value, InvalidVar if there is none
+        order::EqualityClass::Edge edge;   /// shown*firstCoef = var*secondCoef + constant
+        const Clasp::LitVec* condition;    /// the shown variable is shown if one of these literals is true
+    };
+    std::vector<Column> columns_;          /// one for every variable in shown_
+    std::vector<int32> modelValues_;       /// values of all shown variables in the last model, by column
+    std::vector<bool> modelDefined_;       /// whether the shown variable is shown in the last model, by column
     const NameList* names_; /// for every Variable, a name and a disjunction of condition if shown
+    const std::vector<order::Variable>* shown_; /// the variables of names_ in increasing order, the columns of the model, given with names_
+    order::LazyLiteralRegistry* lazyLits_; /// records the lazily created order literals and shares them, may be nullptr
+    order::ConstraintActivity* activity_; /// counts the nogoods produced per linear constraint, may be nullptr
+
+    bool suspended_; /// between two solve steps
+    std::vector<std::pair<Clasp::Literal,uint32> > missed_; /// literals and watch data propagated while suspended
+    std::vector<std::pair<Clasp::Var,OrderWatchIndex::Entry> > sharedWatches_; /// index entries of the shared literals created in this step
+    std::vector<uint64> domainSizes_; /// size of the domain of every variable when the propagator was created or extended
+    OrderWatchProxy* proxy_; /// forwards the order literal watches, may be nullptr
+    Clasp::Constraint* watchTarget_; /// the constraint the order literals are watched with, proxy_ or this
+    uint32 generation_; /// of the order literal watches in proxy_
 
 
     int watchcounter_;
@@ -103,18 +103,29 @@ public:
 
     bool createClause(const LitVec& lvv)
     {
-        ///TODO: currently does a copy, can this be avoided ?
         /// !order::LitVec and Clasp::LitVec are different in debug mode -> PODVector
-        Clasp::LitVec v;
-        v.reserve(lvv.size());
+        /// so the literals are copied into a buffer that keeps its memory
+        clause_.clear();
         for (auto i : lvv)
+            clause_.push_back(toClaspFormat(i));
+        return Clasp::ClauseCreator::create(s_,clause_,0).ok();
+    }
+
+    bool createClauses(const LitVec& clauses)
+    {
+        clause_.clear();
+        for (auto i : clauses)
         {
-            //std::cout << i.sign() << "_" << i.var() << " ";
-            v.push_back(toClaspFormat(i));
+            if (!order::isClauseEnd(i))
+            {
+                clause_.push_back(toClaspFormat(i));
+                continue;
+            }
+            if (!Clasp::ClauseCreator::create(s_,clause_,0).ok())
+                return false;
+            clause_.clear();
         }
-        //std::cout << std::endl;
-        //Clasp::LitVec v(vecToClaspFormat(lvv));
-        return Clasp::ClauseCreator::create(s_,v,0).ok();
+        return true;
     }
 
     bool setEqual(const Literal &a, const Literal &b)
@@ -189,6 +200,7 @@ private:
     Clasp::Var currentVar_;
     Clasp::Var maxVar_;
     unsigned int growth;
+    Clasp::LitVec clause_; /// reused for each clause that is created
 };
 
 
@@ -19,6 +19,7 @@
 // }}}
 
 #include <clingcon/appsupport.h>
+#include <potassco/string_convert.h>
 
 
 namespace clingcon
@@ -28,12 +29,25 @@ using namespace Potassco;
 Helper::Helper(Clasp::SharedContext& ctx, Clasp::Cli::ClaspCliConfig& claspConfig, Clasp::Asp::LogicProgram* lp, order::Config& conf) : ctx_(ctx), td_(lp->theoryData()),
                                                                           lp_(lp), mctx_(ctx), n_(new order::Normalizer(mctx_,conf)),
                                                                           conf_(conf), configurator_(conf_,*n_.get(),to_),
-                                                                          tp_(*n_.get(),td_,lp,mctx_.trueLit())
+                                                                          tp_(*n_.get(),td_,lp,mctx_.trueLit()), unsat_(false)
 {
     claspConfig.addConfigurator(&configurator_,Clasp::Ownership_t::Type::Retain, false);
 
 }
 
+namespace
+{
+    /// n,h of --split-variables, there are only three split points h
+    bool parseSplitVariables(const std::string& value, std::pair<unsigned int,unsigned int>& out)
+    {
+        std::pair<unsigned int,unsigned int> ret;
+        if (!Potassco::string_cast(value, ret) || ret.second > 2)
+            return false;
+        out = ret;
+        return true;
+    }
+}
+
 void Helper::addOptions(ProgramOptions::OptionContext& root, order::Config& conf)
 {
     ProgramOptions::OptionGroup cspconf("Constraint Processing Options", ProgramOptions::desc_level_e1);
@@ -46,9 +60,11 @@ void Helper::addOptions(ProgramOptions::OptionContext& root, order::Config& conf
             ("distinct-pigeon", ProgramOptions::storeTo(conf.pidgeon = true), "Add pigeon-hole constraints for distinct (default: true)")
             ("distinct-permutation", ProgramOptions::storeTo(conf.permutation = false), "Add permutation constraints for distinct (default: false)")
             ("distinct-to-card", ProgramOptions::storeTo(conf.alldistinctCard = false), "Translate distinct constraint using cardinality constraints (default: false)")
+            ("distinct-propagator", ProgramOptions::storeTo(conf.alldistinctProp = false), "Propagate distinct constraints with a bounds consistent propagator instead of translating them (default: false)")
             ("explicit-binary-order", ProgramOptions::storeTo(conf.explicitBinaryOrderClausesIfPossible = false), "Create binary order nogoods if possible (default: false)")
-            ("learn-nogoods", ProgramOptions::storeTo(conf.learnClauses = true), "Learn nogoods while propagating (default: true)")
+            ("learn-nogoods", ProgramOptions::storeTo(conf.learnClauses = true), "Learn nogoods while propagating, otherwise explain propagations on demand (default: true)")
             ("translate-constraints", ProgramOptions::storeTo(conf.translateConstraints = 10000)->arg("<n>"), "Translate constraints with an estimated number of nogoods less than %A (-1=all) (default: 10000)")
+            ("translate-threads", ProgramOptions::storeTo(conf.translateThreads = 1)->arg("<n>"), "Enumerate the nogoods of translated constraints with %A threads (default: 1)")
             ("min-lits-per-var", ProgramOptions::storeTo(conf.minLitsPerVar = 1000)->arg("<n>"), "Creates at least %A literals per variable (-1=all) (default: 1000)")
             ("equality-processing", ProgramOptions::storeTo(conf.equalityProcessing = true), "Replace equal variable views (default: true)")
             ("flatten-optimization", ProgramOptions::storeTo(conf.optimizeOptimize = false), "Flatten the optimization statement (default: true)")
@@ -56,16 +72,20 @@ void Helper::addOptions(ProgramOptions::OptionContext& root, order::Config& conf
             ("sort-descend-coefficient", ProgramOptions::storeTo(conf.descendCoef = true), "Sort constraints by descending coefficients (otherwise ascending) (default: true)")
             ("sort-descend-domain", ProgramOptions::storeTo(conf.descendDom = false), "Sort constraints by descending domain size (otherwise ascending) (default: false)")
             ("prop-strength", ProgramOptions::storeTo(conf.propStrength = 4)->arg("<n>"), "Propagation strength %A {1=weak .. 4=strong} (default: 4)")
-            ("sort-queue", ProgramOptions::storeTo(conf.sortQueue = false), "Sort lazy propagation queue by constraint size (default: false)")
+            ("sort-queue", ProgramOptions::storeTo(conf.sortQueue = false), "Propagate undecided and small constraints first (default: false)")
             ("convert-lazy-variables", ProgramOptions::storeTo(conf.convertLazy = std::make_pair(0,false))->arg("<n,b>"), "Add the union(b=true)/intersection(b=false) of the lazy variables of the first n threads (default: 0,false)")
+            ("shared-lazy-literals", ProgramOptions::storeTo(conf.sharedLazyLiterals = 0)->arg("<n>"), "Reserve %A literals per solve step that all threads share for lazily created order literals (default: 0)")
+            ("translate-hot-constraints", ProgramOptions::storeTo(conf.translateHot = std::make_pair(0,100))->arg("<n,m>"), "Between solve steps, translate the lazy constraints that produced at least m nogoods, most active first, until n nogoods are estimated (0=never, -1=no limit) (default: 0,100)")
+            ("split-variables", ProgramOptions::storeTo(conf.splitVariables = std::make_pair(1,0), parseSplitVariables)->arg("<n,h>"), "If an assignment is no model yet, split the n widest undecided variables (0=all) at h %A {0=middle, 1=lower bound, 2=upper bound} of their domain (default: 1,0)")
             ("dont-care-propagation", ProgramOptions::storeTo(conf.dontcare = true), "Use don't care propagation' (default: true)")
             ;
     root.add(cspconf);
 
     ProgramOptions::OptionGroup hidden("Constraint Processing Options 2",ProgramOptions::desc_level_hidden);
     cspconf.addOptions()
-            //("difference-logic", ProgramOptions::storeTo(conf.dlprop = 0), "0: no difference logic propagator, 1 early, 2 late  (default: 0)")
+            ("difference-logic", ProgramOptions::storeTo(conf.dlprop = 0)->arg("<n>"), "Propagate constraints x-y<=k with a difference logic propagator %A {0=no, 1=before, 2=after the order propagator} (default: 0)")
             ("disjoint-to-distinct", ProgramOptions::storeTo(conf.disjoint2distinct = false), "Translate disjoint to distinct constraint if possible (default: false)")
+            ("disjoint-propagator", ProgramOptions::storeTo(conf.disjointProp = false), "Propagate disjoint constraints lazily instead of translating them (default: false)")
             ;
     root.add(hidden);
 }
@@ -330,20 +350,17 @@ bool Helper::occursInBody(Clasp::Asp::LogicProgram& p, Potassco::Atom_t aId)
 
 bool Helper::postEnd()
 {
-    /// remove all of our propagators, because we will set a new one
-    for (unsigned int i = 0; i != to_.numThreads; ++i)
-    if (to_.props_[i])
-    {
-        assert(ctx_.hasSolver(i));
-        ctx_.solver(i)->removePost(to_.props_[i]);
-        delete to_.props_[i];
-        to_.props_[i] = nullptr;
-    }
+    /// suspend our propagators, they are extended by the constraints of this step
+    /// or replaced by new ones in Configurator::addPost
+    configurator_.suspendProps(ctx_.concurrency());
+    to_.props_.resize(ctx_.concurrency());
 
     if (lp_->end() && ctx_.master()->propagate())
     {
-        bool conflict = false;
-        conflict = !ctx_.master()->propagate();
+        /// a previous step made the problem unsatisfiable
+        bool conflict = unsat_;
+        if (!conflict)
+            conflict = !ctx_.master()->propagate();
         if (!conflict)
         {
 
@@ -353,7 +370,7 @@ bool Helper::postEnd()
                 assert((!tp_.isClingconConstraint(i)) || tdinfo_[count]!=order::Direction::NONE);
                 tp_.readConstraint(i, tdinfo_[count++]);
             }
-            to_.names_ = tp_.postProcess();
+            to_.setNames(tp_.postProcess());
             ctx_.output.theory = &to_;
             simplifyMinimize();
             conflict = !n_->prepare();
@@ -388,17 +405,25 @@ bool Helper::postEnd()
      return true;
 }
 
-void Helper::postSolve()
+bool Helper::postSolve()
 {
-    std::vector<const order::VolatileVariableStorage*> vvs;
-    for (unsigned int thread = 0; thread < std::min(conf_.convertLazy.first,64u); ++thread)
-    {
-        if (to_.props_[thread]==nullptr)
-            break;
-        vvs.emplace_back(&to_.props_[thread]->getVVS());
-    }
+    order::uint64 epoch = n_->constraintEpoch();
+    if (!n_->convertLazyLiterals(std::min(conf_.convertLazy.first, ctx_.concurrency())) ||
+        !n_->translateHotConstraints())
+        unsat_ = true;
+    /// the propagators refer to the constraints by their position, which changed
+    if (epoch != n_->constraintEpoch())
+        configurator_.removeProps();
+    return !unsat_;
+}
 
-    n_->convertAuxLiterals(vvs, ctx_.numVars());
+void Helper::printStatistics(std::ostream& out) const
+{
+    order::QueueStats stats = configurator_.queueStats();
+    out << "Propagation queue:" << std::endl;
+    for (unsigned int i = 0; i < order::QueueStats::numBuckets; ++i)
+        if (stats.wakeups[i])
+            out << "  Bucket " << i << "     : " << stats.wakeups[i] << " (Empty: " << stats.emptyWakeups[i] << ")" << std::endl;
 }
 
 
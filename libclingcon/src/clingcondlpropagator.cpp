@@ -18,9 +18,10 @@
 
 // }}}
 
-/*#include <clingcon/clingcondlpropagator.h>
+#include <clingcon/clingcondlpropagator.h>
 #include <clasp/solver.h>
 #include <clingcon/solver.h>
+#include <algorithm>
 
 
 
@@ -31,10 +32,9 @@ namespace clingcon
 
 bool ClingconDLPropagator::isValidConstraint(const order::ReifiedLinearConstraint& rl) const
 {
-    //rl.normalize();
-    //rl.factorize();
-    return rl.l.getRelation()==order::LinearConstraint::Relation::LE && rl.l.getViews().size()==2 && ((rl.l.getViews().begin()->a==1 && ((rl.l.getViews().begin()+1)->a==-1)) || 
-                                             (rl.l.getViews().begin()->a==-1 && ((rl.l.getViews().begin()+1)->a==1)) );
+    return rl.impl==order::Direction::FWD && rl.l.getRelation()==order::LinearConstraint::Relation::LE && rl.l.getViews().size()==2 &&
+            ((rl.l.getViews().begin()->a==1 && ((rl.l.getViews().begin()+1)->a==-1)) ||
+             (rl.l.getViews().begin()->a==-1 && ((rl.l.getViews().begin()+1)->a==1)) );
 
 }
 
@@ -43,9 +43,7 @@ void ClingconDLPropagator::addValidConstraint(const order::ReifiedLinearConstrai
 {
     //x -y <= c becomes  x-c->y
     assert(isValidConstraint(rl));
-    
-    /// interface changed, ask BENNI
-    //s_.requestData(rl.v.var()); /// have an extra 32bit space for the reason
+
     difflogic::DLPropagator::EdgeId id;
     if (rl.l.getViews()[0].a==-1)
         id = p_.addEdge(rl.l.getViews()[1].v, rl.l.getRhs() - rl.l.getViews()[0].c - rl.l.getViews()[1].c, rl.l.getViews()[0].v);
@@ -53,8 +51,6 @@ void ClingconDLPropagator::addValidConstraint(const order::ReifiedLinearConstrai
         id = p_.addEdge(rl.l.getViews()[0].v, rl.l.getRhs() - rl.l.getViews()[0].c - rl.l.getViews()[1].c, rl.l.getViews()[1].v);
     (void)(id);
     assert(id==(difflogic::DLPropagator::EdgeId)(literals_.size()+1)); /// should be consecutive
-//    literals_.resize(std::max(literals_.size(),(unsigned int)(id)));
-//    literals_[id-1]=toClaspFormat(rl.v);
     literals_.push_back(toClaspFormat(rl.v));
 }
 
@@ -68,49 +64,41 @@ Clasp::Literal ClingconDLPropagator::edgeid2lit(difflogic::DLPropagator::EdgeId
 }
 
 
+bool ClingconDLPropagator::forceFalse(difflogic::DLPropagator::EdgeId id)
+{
+    Clasp::Literal l = edgeid2lit(id);
+    if (s_.isTrue(l))
+        return true;
+    reasons_[l.var()] = id;
+    return s_.force(l,this);
+}
+
+
 Clasp::Constraint::PropResult ClingconDLPropagator::propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data)
 {
-    /// only called if p is gets true (otherwise ~p gets true)
+    /// only watching the literals of the edges, a false literal does not say anything
     assert(s_.isTrue(p));
-    Clasp::Literal l(Clasp::Literal::fromRep(data));
-    difflogic::DLPropagator::EdgeId id = l.var();
-    if (l.sign())
-        id *=-1;
-    pending_.emplace_back(id);
-    //std::cout << "add " << p.var() << "," << p.sign() << " to pending: " << id << " <- id on level " << s_.level(p.var()) << std::endl;
-    
+    (void)(p);
+    if (dls_.back()!=s.decisionLevel())
+    {
+        dls_.emplace_back(s.decisionLevel());
+        activationsPerDl_.emplace_back(0);
+        s_.addUndoWatch(s_.decisionLevel(),this);
+    }
+    pending_.emplace_back(data);
     return PropResult(true, true);
 }
 
 
-void ClingconDLPropagator::reason(Clasp::Solver& s, Clasp::Literal p, Clasp::LitVec& lits)
+void ClingconDLPropagator::reason(Clasp::Solver& , Clasp::Literal p, Clasp::LitVec& lits)
 {
-
     auto it = lits.size();
     (void)(it);
-    Clasp::Literal lid = Clasp::Literal::fromRep(s_.reasonData(p));
-    difflogic::DLPropagator::EdgeId id = lid.var();
-    if (lid.sign())
-        id *=-1;
-    //std::cout << "Need reason for " << p.var() << "," << p.sign() << " which has data " << id << " at level " << s_.level(p.var()) << std::endl;
-    auto reason = p_.reason(id);
-    for (auto i : reason)
+    assert(reasons_.find(p.var())!=reasons_.end());
+    for (auto i : p_.reason(reasons_[p.var()]))
         lits.push_back(edgeid2lit(i));
-//    std::cout << "Reason: ";
-//    for (auto i : reason)
-//    {
-//        Clasp::Literal l = edgeid2lit(i);
-//        std::cout << "Data: " << i << " Literal: " << l.var() << "," << l.sign() << " @" << s_.level(l.var()) << " ";
-//        std::cout << (s_.isFalse(l) ? "false" : (s_.isTrue(l) ? "true" : "unknown"));
-//    }
-//    std::cout << std::endl;
-
 
-
-    assert(std::count_if(lits.begin()+it, lits.end(), [&](Clasp::Literal i){ return s_.isTrue(i); } )==lits.size()-it);
-    //assert(std::count_if(lits.begin()+it, lits.end(), [&](Clasp::Literal i){ return s_.isTrue(i) && (s_.level(i.var()) == s_.decisionLevel()); } )>=1);
-    // i case of conflict minimization, it can happen that the decision literal is higher
-    assert(std::count_if(lits.begin()+it, lits.end(), [&](Clasp::Literal i){ return s_.isTrue(i) && (s_.level(i.var()) == s_.level(p.var())); } )>=1);
+    assert(std::count_if(lits.begin()+it, lits.end(), [&](Clasp::Literal i){ return s_.isTrue(i); } )==(std::ptrdiff_t)(lits.size()-it));
 }
 
 
@@ -118,32 +106,13 @@ bool ClingconDLPropagator::init(Clasp::Solver& s)
 {
     for (unsigned int i = 0; i != literals_.size(); ++i)
     {
-        if (!s.isFalse(literals_[i]) || !s.isTrue(literals_[i]))
-        {
-            s.addWatch(literals_[i],this,Clasp::Literal(i+1,false).rep());
-            s.addWatch(~literals_[i],this,Clasp::Literal(i+1,true).rep());
-        }
-    }
-    for (unsigned int i = 0; i != literals_.size(); ++i)
-    {
-        std::vector<difflogic::DLPropagator::EdgeId> consequences;
         if (s.isFalse(literals_[i]))
-            consequences = p_.deactivate(i+1);
-        else
+            continue;
+        uint32 data = i+1;
         if (s.isTrue(literals_[i]))
-            consequences = p_.activate(i+1);
-            
-        for (const auto& j : consequences)
-        {
-            Clasp::Literal l = edgeid2lit(j);
-            if (!s_.isTrue(l))
-            {
-                if (!s.force(l))
-                    return false;
-                //std::cout << "initially propagated " << l.var() << "," << l.sign() << " to pending: " << j << std::endl;
-                propagated_.push_back(l);
-            }
-        }
+            propagate(s,literals_[i],data);
+        else
+            s.addWatch(literals_[i],this,data);
     }
     return true;
 }
@@ -151,47 +120,26 @@ bool ClingconDLPropagator::init(Clasp::Solver& s)
 
 bool ClingconDLPropagator::propagateFixpoint(Clasp::Solver& , PostPropagator*)
 {
-    if (pending_.size() && dls_.back()<s_.decisionLevel())
-    {
-        dls_.emplace_back(s_.decisionLevel());
-        s_.addUndoWatch(s_.decisionLevel(),this);
-        assert(propagated_.size()==propagated_pointer_);// i do not get called if non of the other propagators has something new
-        propagated_.clear();
-        propagated_pointer_ = 0;
-        activationsPerDl_.emplace_back(0);  
-        //std::cout << "#activationperDL list " << activationsPerDl_.size() << " vs. dl level " << s_.decisionLevel() << std::endl;
-    }
-    
     while(pending_.size())
     {
         for (const auto& i : pending_)
         {
-             Clasp::Literal l = edgeid2lit(i);
-             if (propagated_pointer_<propagated_.size() && propagated_[propagated_pointer_]==l)
-             {  // it was us that made this literal true
-                 ++propagated_pointer_;
-                 continue;
-             }
-             if (!p_.isTrue(i)) /// a literal may actually already be true by some other inference in the solver, so i dont have to activate it again
-             {
-                 //std::cout << "propagate " << l.var() << "," << l.sign() << " @" << s_.level(l.var()) << std::endl;
-                 ++(activationsPerDl_.back());
-                 auto conseq = p_.activate(i);
-                 for (const auto& j : conseq)
-                 {
-                     Clasp::Literal l = edgeid2lit(j);
-                     if (!s_.isTrue(l))
-                     {
-                         //std::cout << "force" << l.var() << "," << l.sign() << " with data "  << j << " at level " << s_.decisionLevel() << std::endl;
-                         if (!s_.force(l,this,Clasp::Literal(abs(j),j<0).rep()))
-                             return false;
-                         propagated_.push_back(l);
-                     }
-                 }
-             }
+            /// an edge is already false if it would close a negative cycle
+            if (p_.isTrue(i))
+                continue;
+            if (p_.isFalse(i))
+            {
+                if (!forceFalse(-i))
+                    return false;
+                continue;
+            }
+            ++(activationsPerDl_.back());
+            for (const auto& j : p_.activate(i))
+                if (!forceFalse(j))
+                    return false;
         }
         pending_.clear();
-        if (!s_.propagateUntil(this))         { return false; } /// only call if propagated_> pointer is not empty
+        if (!s_.propagateUntil(this))         { return false; }
     }
     return true;
 }
@@ -199,30 +147,14 @@ bool ClingconDLPropagator::propagateFixpoint(Clasp::Solver& , PostPropagator*)
 
 void ClingconDLPropagator::reset()
 {
-    if (dls_.back()<=s_.decisionLevel()) /// maybe this can an assert instead of if
-    {
-        //std::cout << "reset " << s_.decisionLevel() << std::endl;
-        propagated_.clear();///
-        propagated_pointer_ = 0;
-        pending_.clear();
-        // i can not undo things here, since reasons may be requested
-        //for (unsigned int i = 0; i != activationsPerDl_.back(); ++i)
-        //    p_.undo();
-        //activationsPerDl_.back()=0;
-    }
-    else
-    {
-        //std::cout << "noreset " << s_.decisionLevel() << std::endl;
-    }
+    /// activated edges are kept until undoLevel, since reasons may be requested
+    pending_.clear();
 }
 
 
-void ClingconDLPropagator::undoLevel(Clasp::Solver& s)
+void ClingconDLPropagator::undoLevel(Clasp::Solver& )
 {
     assert(dls_.back()==s_.decisionLevel());
-    //std::cout << "undo " << s_.decisionLevel() << std::endl;
-    propagated_.clear();
-    propagated_pointer_ = 0;
     pending_.clear();
     for (unsigned int i = 0; i != activationsPerDl_.back(); ++i)
         p_.undo();
@@ -230,11 +162,9 @@ void ClingconDLPropagator::undoLevel(Clasp::Solver& s)
     dls_.pop_back();
 }
 
-bool ClingconDLPropagator::isModel(Clasp::Solver& s)
+bool ClingconDLPropagator::isModel(Clasp::Solver& )
 {
-    return true;
+    return pending_.empty();
 }
 
 }
-
-*/
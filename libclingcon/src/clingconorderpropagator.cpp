@@ -20,14 +20,118 @@
 
 #include <clingcon/clingconorderpropagator.h>
 #include <order/variable.h>
+#include <algorithm>
+#include <cstdio>
 
 
 namespace clingcon
 {
 
+namespace
+{
+    /// the variable that holds the value of shown variable v, v itself or the top variable of its equality class
+    /// returns order::InvalidVar if there is none
+    template <class Storage>
+    order::Variable representative(const Storage& vs, const order::EqualityProcessor::EqualityClassMap& equalities, order::Variable v)
+    {
+        if (v < vs.numVariables() && vs.isValid(v))
+            return v;
+        auto eqsit = equalities.find(v);
+        if (eqsit == equalities.end() || eqsit->second->top() >= vs.numVariables() || !vs.isValid(eqsit->second->top()))
+            return order::InvalidVar;
+        return eqsit->second->top();
+    }
+}
+
+
+OrderWatches::OrderWatches(const order::VariableCreator& vc, const order::Config& conf,
+                           const order::SharedConstraints& constraints, const order::SharedDistincts& distincts,
+                           const order::SharedDisjoints& disjoints, const NameList* names,
+                           const order::EqualityProcessor::EqualityClassMap& equalities) :
+    constraints_(constraints.get()), distincts_(distincts.get()), disjoints_(disjoints.get()), watched_(vc.numVariables(),false)
+{
+    /// same variables as the propagators watch, except that the views of a disjoint constraint are watched
+    /// even if its literal is false, as this depends on the solver
+    for (const auto& c : *constraints)
+        for (auto view : c.l.getConstViews())
+            watched_[view.v]=true;
+    for (const auto& d : *distincts)
+        for (auto view : d.getViews())
+            watched_[view.v]=true;
+    for (const auto& d : *disjoints)
+        for (const auto& group : d.getViews())
+            for (const auto& i : group)
+                watched_[i.first.v]=true;
+    if (names)
+        for (const auto& i : *names)
+        {
+            order::Variable var = representative(vc, equalities, i.first);
+            if (var != order::InvalidVar)
+                watched_[var]=true;
+        }
+
+    domainSizes_.resize(vc.numVariables(),0);
+    std::vector<bool> seen;
+    for (order::Variable var = 0; var != vc.numVariables(); ++var)
+    {
+        if (!vc.isValid(var))
+            continue;
+        domainSizes_[var] = vc.getDomain(var).size();
+        if (!conf.explicitBinaryOrderClausesIfPossible || vc.getStorage(var).numLits() < domainSizes_[var])
+            watched_[var]=true;
+        if (!watched_[var])
+            continue;
+        auto lr = order::pure_LELiteral_iterator(vc.getRestrictor(order::View(var)).begin(), vc.getStorage(var), true);
+        while(lr.isValid())
+        {
+            Clasp::Literal cl = toClaspFormat(*lr);
+            int32 x = cl.sign() ? int32(lr.numElement()+1)*-1 : int32(lr.numElement()+1);
+            index_.add(cl.var(),std::make_pair(var,x));
+            /// a literal that stands for several bounds is watched only once
+            if (cl.var() >= seen.size())
+                seen.resize(cl.var()+1,false);
+            if (!seen[cl.var()])
+            {
+                seen[cl.var()]=true;
+                literals_.emplace_back(cl.var(),false);
+            }
+            ++lr;
+        }
+    }
+    index_.build();
+}
+
+
+bool OrderWatches::fits(const order::VariableCreator& vc, const order::SharedConstraints& constraints,
+                        const order::SharedDistincts& distincts, const order::SharedDisjoints& disjoints) const
+{
+    if (constraints.get()!=constraints_ || distincts.get()!=distincts_ || disjoints.get()!=disjoints_)
+        return false;
+    /// the domains can still be restricted by the top level assignment of a solver
+    if (vc.numVariables()!=domainSizes_.size())
+        return false;
+    for (order::Variable var = 0; var != vc.numVariables(); ++var)
+        if ((vc.isValid(var) ? vc.getDomain(var).size() : 0) != domainSizes_[var])
+            return false;
+    return true;
+}
+
+
+Clasp::Constraint::PropResult OrderWatchProxy::propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data)
+{
+    if (target_ == nullptr || ClingconOrderPropagator::DataBlob::fromRep(data).var() != generation_)
+        return PropResult(true, false);
+    return target_->propagate(s, p, data);
+}
+
 
 Clasp::Constraint::PropResult ClingconOrderPropagator::propagate(Clasp::Solver& s, Clasp::Literal p, uint32& data)
 {
+    if (suspended_)
+    {
+        missed_.emplace_back(p,data);
+        return PropResult(true, true);
+    }
     /// only called if p is gets true (otherwise ~p gets true)
     assert(s_.isTrue(p));
     assert(s_.level(p.var()) == s_.decisionLevel());
@@ -37,6 +141,7 @@ Clasp::Constraint::PropResult ClingconOrderPropagator::propagate(Clasp::Solver&
     {
         //std::cout << "new level " << s.decisionLevel() << std::endl;
         dls_.emplace_back(s.decisionLevel());
+        poolMarks_.emplace_back(reasonPool_.size());
         p_.addLevel();
         s_.addUndoWatch(s_.decisionLevel(), this);
         //std::cout << "Variable storage before getting to the next level " << p_.getVVS().getVariableStorage() << std::endl;
@@ -46,8 +151,8 @@ Clasp::Constraint::PropResult ClingconOrderPropagator::propagate(Clasp::Solver&
     if (blob.sign())
     {
         ///order literal
-        assert(propVar2cspVar_.find(p.var())!=propVar2cspVar_.end());
-        const auto& cspVars = propVar2cspVar_[p.var()];
+        assert(watchIndex_.contains(p.var()));
+        const auto cspVars = watchIndex_.find(p.var());
 
 
         for (const auto& cspVar : cspVars)
@@ -127,7 +232,14 @@ Clasp::Constraint::PropResult ClingconOrderPropagator::propagate(Clasp::Solver&
     {
         /// reification literal
         //std::cout << "received reification lit " << p.rep() << std::endl;
-        p_.queueConstraint(static_cast<std::size_t>(blob.var()));
+        std::size_t id = static_cast<std::size_t>(blob.var());
+        if (id < p_.constraints().size())
+            p_.queueConstraint(id);
+        else
+            if (id < p_.constraints().size()+p_.distincts().size())
+                p_.queueDistinct(id-p_.constraints().size());
+            else
+                p_.queueDisjoint(id-p_.constraints().size()-p_.distincts().size());
     }
     return PropResult(true, true);
 }
@@ -135,13 +247,37 @@ Clasp::Constraint::PropResult ClingconOrderPropagator::propagate(Clasp::Solver&
 
 void ClingconOrderPropagator::reason(Clasp::Solver& , Clasp::Literal p, Clasp::LitVec& lits)
 {
-    if (conflict_.size())
+    assert(inConflict_ || reasons_.find(p.var())!=reasons_.end());
+    const ReasonRecord& record = inConflict_ ? conflict_ : reasons_[p.var()];
+    inConflict_ = false;
+
+    if (record.literals)
     {
-        lits.insert(lits.end(),conflict_.begin(), conflict_.end());
-        conflict_.clear();
+        for (std::size_t i = record.offset; i != record.offset+record.literals; ++i)
+        {
+            Clasp::Literal l = ~Clasp::Literal::fromRep(uint32(reasonPool_[i]));
+            assert(s_.isTrue(l) || l == ~p);
+            if (l != ~p)
+                lits.push_back(l);
+        }
+        return;
+    }
+
+    /// the clause was ~v | ~(x>=bound) for all views x of the constraint
+    const auto& c = p_.constraints()[record.constraint];
+    Clasp::Literal l = toClaspFormat(c.v);
+    if (l != ~p)
+        lits.push_back(l);
+    const auto& vs = p_.getVVS().getVariableStorage();
+    const auto& views = c.l.getViews();
+    for (std::size_t i = 0; i < views.size(); ++i)
+    {
+        auto it = vs.getRestrictor(views[i]).begin() + reasonPool_[record.offset+i];
+        l = toClaspFormat(vs.getGELiteral(it));
+        assert(s_.isTrue(l));
+        if (l != ~p)
+            lits.push_back(l);
     }
-    else
-        lits.insert(lits.end(),reasons_[p.var()].begin(), reasons_[p.var()].end());
 }
 
 
@@ -185,122 +321,134 @@ void ClingconOrderPropagator::forceKnownLiteralLE(order::ViewIterator it, Clasp:
 }
 
 
+Clasp::Literal ClingconOrderPropagator::getGELiteral(const order::ViewIterator& it)
+{
+    auto& vs = p_.getVVS();
+    if (!vs.getVariableStorage().hasGELiteral(it))
+    {
+        auto prev = it-1;
+        auto varit = order::ViewIterator::viewToVarIterator(prev);
+        /// the literal of the variable, the one of a reversed view is its negation
+        unsigned int index = prev.view().reversed() ? varit.numElement()-1 : varit.numElement();
+        order::Literal l = createLELiteral(varit.view().v,index);
+        vs.setLELit(prev,prev.view().reversed() ? ~l : l);
+    }
+
+    /// now it has a literal
+    auto currentIt = vs.getVariableStorage().getCurrentRestrictor(it.view());
+    Clasp::Literal l = toClaspFormat(vs.getVariableStorage().getGELiteral(it));
+    if (!s_.isTrue(l) && !s_.isFalse(l)) /// free value
+    {
+        auto prev = it-1;
+        if (prev < currentIt.begin())
+        {
+            if (prev.view().reversed())
+            {
+                forceKnownLiteralLE(prev,l);
+            }
+            else
+            {
+                forceKnownLiteralGE(prev,l);
+            }
+
+        }
+        else
+            if (currentIt.end () <= prev)
+            {
+                if (prev.view().reversed())
+                {
+                    forceKnownLiteralGE(prev,l);
+                }
+                else
+                {
+                    forceKnownLiteralLE(prev,l);
+                }
+            }
+            /// else it simply free and unit asserting
+    }
+    return l;
+}
+
+
 bool ClingconOrderPropagator::propagateFixpoint(Clasp::Solver& , PostPropagator*)
 {
+    if (suspended_)
+        return true;
     assert(!assertConflict_);
     assert(orderLitsAreOK());
     while (!p_.atFixPoint())
     {
         const auto & clauses = p_.propagateSingleStep();
-        auto& vs = p_.getVVS();
         if (clauses.size())
         {
-            for (const auto& clause : clauses)
-            {               
-                Clasp::LitVec claspClause;
-                claspClause.push_back(toClaspFormat(clause.first));
-
+            if (activity_ && !p_.propagatedDistinct() && !p_.propagatedDisjoint())
+                activity_->mark(p_.propagatedConstraint());
+            for (std::size_t cindex = 0; cindex < clauses.size(); ++cindex)
+            {
+                const auto& clause = clauses[cindex];
                 const auto& its = clause.second;
-                
-                for (unsigned int i = 0; i < its.size(); ++i)
+
+                /// reasons of alldistinct constraints can not be recreated on demand
+                if (conf_.learnClauses || p_.propagatedDistinct())
                 {
-                    if (!vs.getVariableStorage().hasGELiteral(its[i]))
+                    Clasp::LitVec claspClause;
+                    claspClause.push_back(toClaspFormat(clause.first));
+                    for (const auto& it : its)
+                        claspClause.push_back(~getGELiteral(it));
+
+                    ////1=true, 2=false, 0=free
+                    /// all should be isFalse(i)==true, one can be unknown or false
+                    assert(std::count_if(claspClause.begin(), claspClause.end(), [&](Clasp::Literal i){ return s_.isFalse(i); } )>=claspClause.size()-1);
+                    assert(std::count_if(claspClause.begin(), claspClause.end(), [&](Clasp::Literal i){ return s_.isFalse(i) && (s_.level(i.var()) == s_.decisionLevel()); } )>=1);
+
+                    if (!Clasp::ClauseCreator::create(s_,claspClause, Clasp::ClauseCreator::clause_force_simplify, Clasp::ClauseCreator::ClauseInfo(Clasp::Constraint_t::Other)).ok())
+                        return false;
+                }
+                else
+                {
+                    /// explanation on demand, only the implied literal is forced,
+                    /// the clause is recreated in reason() from the constraint and the bounds of its views,
+                    /// the clauses of a disjoint constraint are stored literal by literal as they depend on its conditions
+                    bool disjoint = p_.propagatedDisjoint();
+                    ReasonRecord record(p_.propagatedConstraint(), reasonPool_.size());
+                    Clasp::Literal unit = toClaspFormat(clause.first);
+                    auto addLiteral = [&](Clasp::Literal l)
                     {
-                        order::Literal l = p_.getSolver().getNewLiteral();
-                        auto it = its[i]-1;
-                        vs.setLELit(it,l);
-                        //claspClause.push_back(toClaspFormat(l));
-                        
-                        if (it.view().reversed())
+                        if (!s_.isFalse(l))
                         {
-                            auto varit = order::ViewIterator::viewToVarIterator(it);
-                            addWatch(varit.view().v,~toClaspFormat(l),varit.numElement()-1);
+                            assert(s_.isFalse(unit));
+                            unit = l;
                         }
-                        else
+                    };
+                    if (disjoint)
+                    {
+                        reasonPool_.push_back(unit.rep());
+                        for (auto l : p_.clauseConditions(cindex))
                         {
-                            auto varit = order::ViewIterator::viewToVarIterator(it);
-                            addWatch(varit.view().v,toClaspFormat(l),varit.numElement());
+                            Clasp::Literal cl = toClaspFormat(l);
+                            addLiteral(cl);
+                            reasonPool_.push_back(cl.rep());
                         }
                     }
-                    
-                    /// now it has a literal
+                    for (const auto& it : its)
                     {
-                        auto currentIt = p_.getVVS().getVariableStorage().getCurrentRestrictor(its[i].view());
-                        Clasp::Literal l = toClaspFormat(vs.getVariableStorage().getGELiteral(its[i]));
-                        if (!s_.isTrue(l) && !s_.isFalse(l)) /// free value
-                        {
-                            auto it = its[i]-1;
-                            if (it < currentIt.begin())
-                            {
-                                if (it.view().reversed())
-                                {
-                                    forceKnownLiteralLE(it,l);
-                                }
-                                else
-                                {
-                                    forceKnownLiteralGE(it,l);
-                                }
-                                                            
-                            }
-                            else
-                                if (currentIt.end () <= it)
-                                {
-                                    if (it.view().reversed())
-                                    {
-                                        forceKnownLiteralGE(it,l);
-                                    }
-                                    else
-                                    {
-                                        forceKnownLiteralLE(it,l);
-                                    }
-                                }
-                                /// else it simply free and unit asserting    
-                        }
-                        
-                        claspClause.push_back(~l);
+                        Clasp::Literal l = ~getGELiteral(it);
+                        addLiteral(l);
+                        reasonPool_.push_back(disjoint ? uint64(l.rep()) : uint64(it.numElement()));
                     }
-                }
-                
-                ////1=true, 2=false, 0=free
-                /// all should be isFalse(i)==true, one can be unknown or false
-//                              std::cout << "Give clasp the clause " << std::endl;
-//                              for (auto i : claspClause)
-//                                  std::cout << i.rep() << "@" << s_.level(i.var()) << "isFalse?" << s_.isFalse(i) << " isTrue" << s_.isTrue(i) << "  ,   ";
-//                              std::cout << " on level " << s_.decisionLevel();
-//                              std::cout << std::endl;
-                assert(std::count_if(claspClause.begin(), claspClause.end(), [&](Clasp::Literal i){ return s_.isFalse(i); } )>=claspClause.size()-1);
-                assert(std::count_if(claspClause.begin(), claspClause.end(), [&](Clasp::Literal i){ return s_.isFalse(i) && (s_.level(i.var()) == s_.decisionLevel()); } )>=1);
-
-
-                if (conf_.learnClauses)
-                {
-                    if (!Clasp::ClauseCreator::create(s_,claspClause, Clasp::ClauseCreator::clause_force_simplify, Clasp::ClauseCreator::ClauseInfo(Clasp::Constraint_t::Other)).ok())
-                        return false;
-                }
-                else
-                {
-
-                    ///TODO: what about the return value
-                    Clasp::ClauseCreator::prepare(s_, claspClause, Clasp::ClauseCreator::clause_force_simplify);
+                    if (disjoint)
+                        record.literals = reasonPool_.size()-record.offset;
 
-                    if (claspClause.size()==0) /// top level conflict
-                        claspClause.push_back(Clasp::negLit(0));
-
-                    /// in case of a conflict we do not want to override reason of the same literal
-                    if (s_.isFalse(*claspClause.begin()))
+                    if (s_.isTrue(unit)) /// clause already satisfied
+                        continue;
+                    if (s_.isFalse(unit)) /// conflict, all literals are false
                     {
-                        conflict_.clear();
-                        for (auto i = claspClause.begin()+1; i != claspClause.end(); ++i)
-                            conflict_.push_back(~(*i));
+                        conflict_ = record;
+                        inConflict_ = true;
                     }
                     else
-                    {
-                        reasons_[claspClause.begin()->var()].clear();
-                        conflict_.clear();
-                        for (auto i = claspClause.begin()+1; i != claspClause.end(); ++i)
-                            reasons_[claspClause.begin()->var()].push_back(~(*i));
-                    }
-                    if (!s_.force(*claspClause.begin(),this))
+                        reasons_[unit.var()] = record;
+                    if (!s_.force(unit,this))
                         return false;
                 }
             }
@@ -314,11 +462,305 @@ bool ClingconOrderPropagator::propagateFixpoint(Clasp::Solver& , PostPropagator*
 
 void ClingconOrderPropagator::addWatch(const order::Variable& var, const Clasp::Literal& cl, unsigned int step)
 {
-    DataBlob blob(0, true);
-    s_.addWatch(cl, this, blob.rep());
-    s_.addWatch(~cl, this, blob.rep());
+    DataBlob blob(generation_, true);
+    s_.addWatch(cl, watchTarget_, blob.rep());
+    s_.addWatch(~cl, watchTarget_, blob.rep());
     int32 x = cl.sign() ? int32(step+1)*-1 : int32(step+1);
-    propVar2cspVar_[cl.var()].emplace_back(std::make_pair(var,x));
+    watchIndex_.add(cl.var(),std::make_pair(var,x));
+}
+
+
+void ClingconOrderPropagator::watchConstraints(std::size_t cindex)
+{
+    const auto& constraints = p_.constraints();
+    for (; cindex < constraints.size(); ++cindex)
+    {
+        for (auto view : constraints[cindex].l.getConstViews())
+        {
+            watched_[view.v]=true;
+        }
+        /// just watch the nonfalse ones
+        Clasp::Literal l = toClaspFormat(constraints[cindex].v);
+        if (!s_.isFalse(l)) /// permanent false otherwise, do not need to consider it
+        {
+            DataBlob blob(cindex,false);
+            s_.addWatch(l, this, blob.rep());
+            //s.addWatch(~l, this, blob.asUint()); // i'm just watching implications
+        }
+    }
+}
+
+
+void ClingconOrderPropagator::watchGlobals()
+{
+    const auto& distincts = p_.distincts();
+    const auto& disjoints = p_.disjoints();
+    std::size_t offset = p_.constraints().size();
+
+    /// alldistinct constraints are numbered after the linear ones
+    for (std::size_t dindex = 0; dindex < distincts.size(); ++dindex)
+    {
+        for (auto view : distincts[dindex].getViews())
+            watched_[view.v]=true;
+        Clasp::Literal l = toClaspFormat(distincts[dindex].getLiteral());
+        if (!s_.isFalse(l))
+        {
+            DataBlob blob(offset+dindex,false);
+            s_.addWatch(l, this, blob.rep());
+        }
+    }
+
+    /// disjoint constraints are numbered after the alldistinct ones,
+    /// they are also woken up if a condition gets true
+    for (std::size_t dindex = 0; dindex < disjoints.size(); ++dindex)
+    {
+        const auto& d = disjoints[dindex];
+        Clasp::Literal l = toClaspFormat(d.getLiteral());
+        if (s_.isFalse(l))
+            continue;
+        DataBlob blob(offset+distincts.size()+dindex,false);
+        s_.addWatch(l, this, blob.rep());
+        for (const auto& group : d.getViews())
+            for (const auto& i : group)
+            {
+                watched_[i.first.v]=true;
+                Clasp::Literal cond = toClaspFormat(i.second);
+                if (!s_.isTrue(cond) && !s_.isFalse(cond))
+                    s_.addWatch(cond, this, blob.rep());
+            }
+    }
+}
+
+
+bool ClingconOrderPropagator::needsOrderWatches(order::Variable var) const
+{
+    const auto& vs = p_.getVVS().getVariableStorage();
+    if (!vs.isValid(var))
+        return false;
+    if (!conf_.explicitBinaryOrderClausesIfPossible)
+        return true;
+    return vs.getOrderStorage(var).numLits() < vs.getDomain(var).size();
+}
+
+
+void ClingconOrderPropagator::watchShown()
+{
+    if (!names_)
+        return;
+    for (const auto& i : *names_)
+    {
+        order::Variable var = representative(p_.getVVS().getVariableStorage(), eqs_, i.first);
+        if (var != order::InvalidVar)
+            watched_[var]=true;
+    }
+}
+
+
+void ClingconOrderPropagator::watchOrderLiterals(order::Variable var)
+{
+    const auto& vs = p_.getVVS().getVariableStorage();
+    auto lr = order::pure_LELiteral_iterator(vs.getRestrictor(order::View(var)).begin(), vs.getOrderStorage(var), true);
+    while(lr.isValid())
+    {
+        ///TODO: do i need to do this for true lits ?
+        addWatch(var,toClaspFormat(*lr),lr.numElement());
+        ++lr;
+    }
+}
+
+
+void ClingconOrderPropagator::storeDomainSizes()
+{
+    const auto& vs = p_.getVVS().getVariableStorage();
+    domainSizes_.resize(vs.numVariables());
+    for (std::size_t var = 0; var != vs.numVariables(); ++var)
+        domainSizes_[var] = vs.isValid(var) ? vs.getDomain(var).size() : 0;
+}
+
+
+void ClingconOrderPropagator::collectSplitCandidates()
+{
+    splitCandidates_.clear();
+    /// a variable with all of its order literals is decided by the solver and never split,
+    /// only such variables are watched just because they are shown, see needsOrderWatches
+    for (order::Variable var = 0; var != watched_.size(); ++var)
+        if (watched_[var] && needsOrderWatches(var))
+            splitCandidates_.emplace_back(var);
+}
+
+
+std::size_t ClingconOrderPropagator::splitPoint(std::size_t size, unsigned int h)
+{
+    assert(size>1);
+    assert(h<=2);
+    /// the literal var<=element, so the upper bound is split off with the second last element
+    if (h==1)
+        return 0;
+    if (h==2)
+        return size-2;
+    return (size-1)/2;
+}
+
+
+void ClingconOrderPropagator::split(order::Variable var)
+{
+    auto lr = p_.getVVS().getVariableStorage().getCurrentRestrictor(order::View(var));
+    auto it = lr.begin() + splitPoint(lr.size(),conf_.splitVariables.second);
+    order::Literal l = createLELiteral(var,it.numElement());
+    p_.getVVS().setLELit(it,l);
+    //std::cout << "Added V" << var << "<=" << *it << std::endl;
+}
+
+
+order::Literal ClingconOrderPropagator::createLELiteral(order::Variable var, unsigned int index)
+{
+    if (lazyLits_ && s_.id() < conf_.convertLazy.first)
+        lazyLits_->mark(var,index);
+    /// a shared literal that is already assigned in this solver can not be given its meaning afterwards,
+    /// isModel checks that it agrees with the bound
+    order::Literal l = p_.getSolver().trueLit();
+    if (lazyLits_ && lazyLits_->share(var,index,l) && s_.value(toClaspFormat(l).var())==Clasp::value_free)
+    {
+        Clasp::Literal cl = toClaspFormat(l);
+        addWatch(var,cl,index);
+        sharedWatches_.emplace_back(cl.var(),std::make_pair(var,cl.sign() ? int32(index+1)*-1 : int32(index+1)));
+        return l;
+    }
+    l = p_.getSolver().getNewLiteral();
+    addWatch(var,toClaspFormat(l),index);
+    return l;
+}
+
+
+bool ClingconOrderPropagator::checkSharedLiterals()
+{
+    const auto& vs = p_.getVVS().getVariableStorage();
+    for (std::size_t i = 0; i != lazyLits_->poolSize(); ++i)
+    {
+        Clasp::Literal l = toClaspFormat(lazyLits_->poolLiteral(i));
+        order::Variable var;
+        unsigned int index;
+        Clasp::LitVec clause;
+        if (!lazyLits_->poolBound(i,var,index))
+        {
+            /// stands for nothing
+            if (s_.isFalse(l))
+                continue;
+            clause.push_back(~l);
+        }
+        else
+        {
+            auto lr = vs.getCurrentRestrictor(order::View(var));
+            assert(lr.size()==1);
+            bool le = lr.begin().numElement() <= index;
+            if (le == s_.isTrue(l))
+                continue;
+            /// the value of var implies the bound
+            if (le)
+            {
+                clause.push_back(l);
+                clause.push_back(getGELiteral(lr.end()));
+            }
+            else
+            {
+                clause.push_back(~l);
+                clause.push_back(~getGELiteral(lr.begin()));
+            }
+        }
+        if (!Clasp::ClauseCreator::create(s_,clause, Clasp::ClauseCreator::clause_force_simplify, Clasp::ClauseCreator::ClauseInfo(Clasp::Constraint_t::Other)).ok())
+            return false;
+    }
+    return true;
+}
+
+
+bool ClingconOrderPropagator::extend(const order::VariableCreator& vc, const order::SharedConstraints& constraints,
+                                     const order::SharedDistincts& distincts, const order::SharedDisjoints& disjoints)
+{
+    assert(suspended_);
+    if (s_.decisionLevel()!=0 || s_.hasConflict())
+        return false;
+    /// the global constraints are numbered after the linear ones, so their watches would have to be renumbered
+    if (distincts.get()!=&p_.distincts() || disjoints.get()!=&p_.disjoints() ||
+        ((distincts->size() || disjoints->size()) && constraints->size()!=p_.constraints().size()))
+        return false;
+    if (constraints->size() < p_.constraints().size())
+        return false;
+    /// the restrictors and the watched order literals refer to positions in the old domains
+    for (order::Variable var = 0; var != domainSizes_.size(); ++var)
+    {
+        uint64 size = vc.isValid(var) ? vc.getDomain(var).size() : 0;
+        if (size != domainSizes_[var])
+            return false;
+    }
+
+    /// the reasons refer to positions in the old constraints and bounds, and clasp asks for none on the top level
+    reasons_.clear();
+    reasonPool_.clear();
+    poolMarks_.clear();
+    inConflict_ = false;
+    assertConflict_ = false;
+
+    /// the literals created by this solver during the last step are removed by clasp at the end of the step,
+    /// so the watch index is rebuilt from the entries of the shared literals, and only
+    /// the shared literals that have been created in the meantime get a watch
+    watchIndex_.reopen();
+    /// the shared literals are no local ones and keep their watches
+    for (const auto& i : sharedWatches_)
+        watchIndex_.add(i.first,i.second);
+    sharedWatches_.clear();
+    std::size_t oldVars = watched_.size();
+    for (order::Variable var = 0; var != oldVars; ++var)
+    {
+        if (!watched_[var] || !vc.isValid(var))
+            continue;
+        const order::orderStorage& local = p_.getVVS().getStorage(var);
+        vc.getStorage(var).forEach([&](unsigned int index, order::Literal l)
+        {
+            if (local.hasNoLiteral(index) || local.getLiteral(index)!=l)
+                addWatch(var,toClaspFormat(l),index);
+        });
+    }
+    p_.getVVS().extend(vc);
+
+    std::vector<bool> before(watched_);
+    watched_.resize(p_.getVVS().getVariableStorage().numVariables(),false);
+    std::size_t oldConstraints = p_.constraints().size();
+    p_.extendImp(constraints);
+    watchConstraints(oldConstraints);
+    for (std::size_t var = oldVars; var != vc.numVariables(); ++var)
+        if (needsOrderWatches(var))
+            watched_[var]=true;
+    watchShown();
+    for (std::size_t var = 0; var != watched_.size(); ++var)
+        if (watched_[var] && (var >= oldVars || !before[var]))
+            watchOrderLiterals(var);
+    watchIndex_.build();
+    storeDomainSizes();
+    collectSplitCandidates();
+    collectColumns();
+    return true;
+}
+
+
+bool ClingconOrderPropagator::resume()
+{
+    assert(suspended_);
+    suspended_ = false;
+    std::vector<std::pair<Clasp::Literal,uint32> > missed;
+    missed.swap(missed_);
+    for (auto& i : missed)
+    {
+        /// assignments above the top level have been undone in the meantime
+        if (!s_.validVar(i.first.var()) || !s_.isTrue(i.first) || s_.level(i.first.var())!=0)
+            continue;
+        DataBlob blob(DataBlob::fromRep(i.second));
+        if (blob.sign() && !watchIndex_.contains(i.first.var()))
+            continue;
+        if (!propagate(s_, i.first, i.second).ok)
+            return false;
+    }
+    return true;
 }
 
 
@@ -388,6 +830,8 @@ void ClingconOrderPropagator::undoLevel(Clasp::Solver&)
     assertConflict_ = false;
     p_.removeLevel();
     dls_.pop_back();
+    reasonPool_.resize(poolMarks_.back());
+    poolMarks_.pop_back();
 }
 
 
@@ -419,90 +863,75 @@ ForwardIt my_upper_bound(ForwardIt first, ForwardIt last, Clasp::Solver& s, cons
 
 bool ClingconOrderPropagator::isModel(Clasp::Solver& )
 {
+    if (suspended_)
+        return true;
     //std::cout << "Is probably a model ?" << " at dl " << s_.decisionLevel() << std::endl;
     auto& vs = p_.getVVS().getVariableStorage();
 
-    order::Variable unrestrictedVariable(order::InvalidVar);
-    unsigned int maxSize=1;
-    for (unsigned int i = 0; i < vs.numVariables(); ++i)
+    undecided_.clear();
+    for (auto var : splitCandidates_)
     {
-        if (p_.getVVS().getVariableStorage().isValid(i) && watched_[i])
-        {
-            auto lr = vs.getCurrentRestrictor(i);
-    
-            if (lr.size()>maxSize)
-            {
-                maxSize=lr.size();
-                unrestrictedVariable=i;
-            }
-        }
+        uint64 size = vs.getCurrentRestrictor(var).size();
+        if (size>1)
+            undecided_.emplace_back(size,var);
     }
 
-    if (maxSize>1) /// there is some unknownness
+    if (!undecided_.empty()) /// there is some unknownness
     {
-        auto lr = vs.getCurrentRestrictor(order::View(unrestrictedVariable));
-        auto it = lr.begin() + ((maxSize-1)/2);
-        order::Literal l = p_.getSolver().getNewLiteral();
-        p_.getVVS().setLELit(it,l);
-        //std::cout << "Added V" << unrestrictedVariable << "<=" << *it << std::endl;
-        addWatch(unrestrictedVariable,toClaspFormat(l),it.numElement());
+        /// the widest variables first, on ties the smallest variable
+        auto wider = [](const std::pair<uint64,order::Variable>& a, const std::pair<uint64,order::Variable>& b)
+        { return a.first > b.first || (a.first == b.first && a.second < b.second); };
+        std::size_t num = undecided_.size();
+        if (conf_.splitVariables.first != 0 && conf_.splitVariables.first < num)
+        {
+            num = conf_.splitVariables.first;
+            std::nth_element(undecided_.begin(), undecided_.begin()+(num-1), undecided_.end(), wider);
+        }
+        for (std::size_t i = 0; i != num; ++i)
+            split(undecided_[i].second);
         return false;
     } 
     else
     {
+        /// a pool literal that disagrees with the model is repaired by a conflict
+        if (lazyLits_ && lazyLits_->poolSize() && !checkSharedLiterals())
+            return false;
+
         /// store the model to be printed later
-        if (names_)
-        for (auto it = names_->begin(); it != names_->end(); ++it)
-        //for (order::Variable v = 0; v < p_.getVVS().getVariableStorage().numVariables(); ++v)
+        for (std::size_t c = 0; c != columns_.size(); ++c)
         {
-            
+            const Column& col = columns_[c];
             bool fulfilled = false;
             /// or none of the lits is true
-            for (auto lit : it->second.second)
+            for (auto lit : *col.condition)
                 if (s_.isTrue(lit))
                 {
                     fulfilled = true;
                     break;
                 }
-            if(!fulfilled)
-            {
-                lastModel_.erase(it->first);
+            modelDefined_[c] = fulfilled;
+            if (!fulfilled)
                 continue;
-            }
+            assert(col.var != order::InvalidVar); // the variable or its equality class is valid
 
-            order::Variable v(it->first);
-            order::EqualityClass::Edge e(1,1,0);
-            //const order::EqualityProcessor::EqualityClassMap::iterator eqsit;
-            order::Variable var(v);
-            if (!p_.getVVS().getVariableStorage().isValid(v))
-            {
-                auto eqsit = eqs_.find(v);
-                assert(eqsit != eqs_.end());// should be inside, otherwise variable is valid
-                assert(eqsit->second->top()!=v); // should not be top variable -> otherwise variable is valid
-                auto& constraints = eqsit->second->getConstraints();
-                assert(constraints.find(v) != constraints.end());
-                e = constraints.find(v)->second;   
-                var = eqsit->second->top();
-            }
-        
+            const order::EqualityClass::Edge& e = col.edge;
             order::ViewIterator vit;
-            if (watched_[var])
+            if (watched_[col.var])
             {
                 order::Restrictor lr;
-                lr = p_.getVVS().getVariableStorage().getCurrentRestrictor(var);
+                lr = p_.getVVS().getVariableStorage().getCurrentRestrictor(col.var);
                 assert(lr.size()==1);
                 vit = lr.begin();
             }
-            else /// not watched, need to search for value
+            else /// shown variables are watched, so this is only a fallback, need to search for value
             {
-                auto rs = p_.getVVS().getVariableStorage().getRestrictor(order::View(var));
-                vit = my_upper_bound(rs.begin(), rs.end(),s_,p_.getVVS().getVariableStorage().getOrderStorage(var));
+                auto rs = p_.getVVS().getVariableStorage().getRestrictor(order::View(col.var));
+                vit = my_upper_bound(rs.begin(), rs.end(),s_,p_.getVVS().getVariableStorage().getOrderStorage(col.var));
             }
             int32 value = (((int64)(e.secondCoef) * (int64)(*vit)) + (int64)(e.constant))/(int64)(e.firstCoef);
             assert((((int64)(e.secondCoef) * (int64)(*vit)) + (int64)(e.constant)) % (int64)(e.firstCoef) == 0);
-            lastModel_[v]=value;
+            modelValues_[c]=value;
         }
-        
     }
 
     return true;
@@ -510,26 +939,54 @@ bool ClingconOrderPropagator::isModel(Clasp::Solver& )
 
 
 
-const char* ClingconOrderPropagator::printModel(order::Variable v, const std::string& name)
+const char* ClingconOrderPropagator::printModel(std::size_t column, const std::string& name)
 {
-    auto find = lastModel_.find(v);
-    if (find== lastModel_.end())
+    if (column >= modelDefined_.size() || !modelDefined_[column])
         return 0;
-    //std::cout << "enter printModel " << v << " " << name << std::endl;
-    outputbuf_ = name;
-    outputbuf_ += "=";
-    outputbuf_ += std::to_string(find->second);
+    //std::cout << "enter printModel " << columns_[column].shown << " " << name << std::endl;
+    char value[16];
+    int len = std::snprintf(value, sizeof(value), "%d", modelValues_[column]);
+    outputbuf_.assign(name);
+    outputbuf_ += '=';
+    outputbuf_.append(value, len);
     return outputbuf_.c_str();  
 }
 
-bool ClingconOrderPropagator::getValue(order::Variable v, int32& value)
+bool ClingconOrderPropagator::getValue(std::size_t column, int32& value)
 {
-    auto find = lastModel_.find(v);
-    if (find== lastModel_.end())
+    if (column >= modelDefined_.size() || !modelDefined_[column])
         return false;
-    value = find->second;
+    value = modelValues_[column];
     return true;
 }
 
+
+void ClingconOrderPropagator::collectColumns()
+{
+    columns_.clear();
+    if (names_)
+    {
+        assert(shown_ && shown_->size()==names_->size());
+        const auto& vs = p_.getVVS().getVariableStorage();
+        for (order::Variable v : *shown_)
+        {
+            Column col;
+            col.shown = v;
+            col.var = representative(vs, eqs_, v);
+            col.edge = order::EqualityClass::Edge(1,1,0);
+            col.condition = &names_->find(v)->second.second;
+            if (col.var != order::InvalidVar && col.var != v)
+            {
+                auto& constraints = eqs_.find(v)->second->getConstraints();
+                assert(constraints.find(v) != constraints.end());
+                col.edge = constraints.find(v)->second;
+            }
+            columns_.emplace_back(col);
+        }
+    }
+    modelValues_.assign(columns_.size(),0);
+    modelDefined_.assign(columns_.size(),false);
+}
+
 }
 
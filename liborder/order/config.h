@@ -24,6 +24,9 @@
 
 #pragma once
 #include <order/types.h>
+#include <utility>
+#include <algorithm>
+#include <cassert>
 
 
 namespace order
@@ -38,9 +41,9 @@ public:
            unsigned int domSize, bool break_symmetries,
            std::pair<int64,int64> splitsize_maxClauseSize,
            bool pidgeon, bool permutation, bool disjoint2distinct,
-           bool alldistinctCard, bool explicitBinaryOrderClauses,
+           bool alldistinctCard, bool alldistinctProp, bool disjointProp, bool explicitBinaryOrderClauses,
            bool learnClauses, unsigned int dlprop,
-           int64 translateConstraints, int64 minLitsPerVar,
+           int64 translateConstraints, unsigned int translateThreads, int64 minLitsPerVar,
            bool equalityProcessing, bool optimizeOptimize,
            bool coefFirst, bool descendCoef, bool descendDom,
            unsigned int propStrength, bool sortQueue,
@@ -49,9 +52,9 @@ public:
         domSize(domSize), break_symmetries(break_symmetries),
         splitsize_maxClauseSize(splitsize_maxClauseSize),
         pidgeon(pidgeon), permutation(permutation), disjoint2distinct(disjoint2distinct),
-        alldistinctCard(alldistinctCard), explicitBinaryOrderClausesIfPossible(explicitBinaryOrderClauses),
+        alldistinctCard(alldistinctCard), alldistinctProp(alldistinctProp), disjointProp(disjointProp), explicitBinaryOrderClausesIfPossible(explicitBinaryOrderClauses),
         learnClauses(learnClauses), dlprop(dlprop),
-        translateConstraints(translateConstraints),
+        translateConstraints(translateConstraints), translateThreads(translateThreads),
         minLitsPerVar(minLitsPerVar), equalityProcessing(equalityProcessing),
         optimizeOptimize(optimizeOptimize),
         coefFirst(coefFirst), descendCoef(descendCoef), descendDom(descendDom),
@@ -76,11 +79,14 @@ public:
     bool permutation; /// apply permutation constraint to alldifferent cosntraints
     bool disjoint2distinct; /// try to convert a disjoint constraint to an alldistinct constraint
     bool alldistinctCard; /// translate alldistinct with cardinality constraints
+    bool alldistinctProp; /// propagate alldistinct implications with a bounds consistent propagator instead of translating them
+    bool disjointProp; /// propagate disjoint implications lazily instead of translating them
     bool explicitBinaryOrderClausesIfPossible; /// have the order clauses explicit or in a propagator
     /// be careful with explicitBinaryOrderClauses as it is not compatible with bool translate which has to be implemented yet
-    bool learnClauses; /// learn clauses while propagating, default true
+    bool learnClauses; /// learn clauses while propagating, otherwise reasons are created on demand, default true
     unsigned int dlprop; /// 0 = no difference logic propagator, 1 =dl prop comes before linear order prop, 2 =dl prop comes after
     int64 translateConstraints; // translate constraint if expected number of clauses is less than this number (-1 = all)
+    unsigned int translateThreads; // enumerate the clauses of translated constraints with this number of threads, they are created in the same order afterwards
     int64 minLitsPerVar; // precreate at least this number of literals per variable (-1 = all)
     bool equalityProcessing; // enable equality processing
     bool optimizeOptimize; /// replace single variables in optimize statement with their sum
@@ -88,9 +94,18 @@ public:
     bool descendCoef; /// sort constraints by decreasing coefficients
     bool descendDom; /// sort constraints by decreasing domain size
     unsigned int propStrength; /// propagation strength for lazy constraints 1..4
-    bool sortQueue; /// sort the lazy propagation queue by constraint size (makes sense without splitting)
+    bool sortQueue; /// schedule the lazy propagation queue by reification state and constraint size (makes sense without splitting)
     std::pair<unsigned int,bool> convertLazy;
     bool dontcare; /// option for testing strict/vs fwd/back inferences only
+    std::pair<int64,unsigned int> translateHot = std::make_pair(0,100); /// between solve steps, translate lazy constraints that produced nogoods at least second times,
+                                                                        /// hottest first, until first nogoods have been estimated (0 = never, -1 = no limit)
+    std::pair<unsigned int,unsigned int> splitVariables = std::make_pair(1,0); /// if an assignment is no model yet, split the first widest undecided variables (0 = all)
+                                                                               /// at the middle (second=0), the lower (1) or the upper bound (2) of their current domain
+    unsigned int sharedLazyLiterals = 0; /// size of the pool of literals the solver threads share for the lazily created order literals of a solve step
+
+    Config& setTranslateHot(int64 nogoods, unsigned int minActivity) { translateHot = std::make_pair(nogoods,minActivity); return *this; }
+    Config& setSplitVariables(unsigned int n, unsigned int h) { assert(h <= 2); splitVariables = std::make_pair(n,h); return *this; }
+    Config& setSharedLazyLiterals(unsigned int n) { sharedLazyLiterals = n; return *this; }
 };
 
 
@@ -31,14 +31,27 @@ namespace order
 {
 
 //for testing
-static Config lazySolveConfigProp1 = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,1000,1000,true,true, false,true,false, 1,true,std::make_pair(64,true),false);
-static Config lazySolveConfigProp2 = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,1000,1000,true,true, false,true,false, 2,true,std::make_pair(64,false),false);
-static Config lazySolveConfigProp3 = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,1000,1000,true,true, false,true,false, 3,true,std::make_pair(64,true),true);
-static Config lazySolveConfigProp4 = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,1000,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+static Config lazySolveConfigProp1 = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,1000,1,1000,true,true, false,true,false, 1,true,std::make_pair(64,true),false);
+static Config lazySolveConfigProp2 = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,1000,1,1000,true,true, false,true,false, 2,true,std::make_pair(64,false),false);
+static Config lazySolveConfigProp3 = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,1000,1,1000,true,true, false,true,false, 3,true,std::make_pair(64,true),true);
+static Config lazySolveConfigProp4 = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
 // actually not non lazy, just creates all literals, but no constraints are translated
-static Config nonlazySolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,0,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
-static Config lazyDiffSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,0,1000,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
-static Config translateConfig = Config(true,10000,false,{3,1024},true,true,true,false,true,true,0,-1,1000,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
-
-static std::vector<Config> conf1({lazySolveConfigProp1,lazySolveConfigProp2,lazySolveConfigProp3,lazySolveConfigProp4,nonlazySolveConfig});
+static Config nonlazySolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,0,1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
+static Config lazyDiffSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,0,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
+// does not learn nogoods while propagating, reasons are given on demand
+static Config lazyExplainSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,false,0,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+// additionally propagates difference constraints with the difference logic propagator, before/after the order propagator
+static Config lazyDLEarlySolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,1,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+static Config lazyDLLateSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,false,2,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+// propagates alldistinct constraints instead of translating them into pairwise inequalities
+static Config lazyDistinctSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,true,false,true,true,0,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+// propagates disjoint constraints instead of translating them
+static Config lazyDisjointSolveConfig = Config(true,10000,false,{3,1024},true,true,false,false,false,true,true,true,0,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true);
+// completes assignments by splitting the 4 widest undecided variables at once, at their lower bound
+static Config lazySplitSolveConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,1000,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,false),true).setSplitVariables(4,1);
+static Config translateConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,-1,1,1000,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
+// translates all constraints, the nogoods are enumerated by 4 threads
+static Config parallelTranslateConfig = Config(true,10000,false,{3,1024},true,true,true,false,false,false,true,true,0,-1,4,1000,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
+
+static std::vector<Config> conf1({lazySolveConfigProp1,lazySolveConfigProp2,lazySolveConfigProp3,lazySolveConfigProp4,nonlazySolveConfig,lazyExplainSolveConfig,lazyDLEarlySolveConfig,lazyDLLateSolveConfig,lazyDistinctSolveConfig,lazyDisjointSolveConfig,lazySplitSolveConfig,parallelTranslateConfig});
 }
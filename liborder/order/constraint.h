@@ -61,7 +61,7 @@ public:
     friend ReifiedLinearConstraint;
 
     enum class Relation : short {LT, LE, GT, GE, EQ, NE};
-    LinearConstraint(Relation r) : constant_(0) , r_(r), flag_(false), normalized_(false) {}
+    LinearConstraint(Relation r) : constant_(0) , r_(r), normalized_(false) {}
     //LinearConstraint(const LinearConstraint& o) : vars_(o.vars_), constant_(o.constant_), r_(o.r_), flag_(o.flag_) {}
     //LinearConstraint(LinearConstraint&& o) : vars_(std::move(o.vars_)), constant_(o.constant_), r_(o.r_), flag_(o.flag_) {}
     bool operator==(const LinearConstraint& r) const { return r_==r.r_ && constant_==r.constant_ && views_==r.views_; }
@@ -77,8 +77,6 @@ public:
     void times(int32 x);
     int getRhs() const { return constant_; }
 
-    bool getFlag() const { return flag_; }
-    void setFlag(bool b) { flag_ = b; }
     bool normalized() const {return normalized_; }
 
 
@@ -150,7 +148,6 @@ private:
     std::vector<View> views_; /// should only contain views with b==1 and c==0
     int constant_; // rhs
     Relation r_;
-    bool flag_;
     bool normalized_;
 };
 
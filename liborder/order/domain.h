@@ -25,6 +25,7 @@
 #pragma once
 #include <order/solver.h>
 #include <order/types.h>
+#include <order/smallvector.h>
 
 #include <vector>
 #include <cassert>
@@ -36,16 +37,22 @@
 namespace order
 {
 
+/// the arithmetic progression l, l+s, l+2s, ..., u
+/// pre: (u-l)%s==0, s==1 if l==u
 class Range
 {
 public:
-    Range(int32 lower,int32 upper) : l(lower), u(upper) {}
-    bool operator==(const Range& d) const { return l==d.l && u==d.u; }
-    bool operator!=(const Range& d) const { return l!=d.l || u!=d.u; }
+    Range(int32 lower,int32 upper, int32 stride = 1) : l(lower), u(upper), s(stride) {}
+    bool operator==(const Range& d) const { return l==d.l && u==d.u && s==d.s; }
+    bool operator!=(const Range& d) const { return !(*this==d); }
     int32 l,u;
-    int64 size() const { return ((int64)u - (int64)l) + 1;}
+    int32 s; /// the distance between two elements
+    int64 size() const { return ((int64)u - (int64)l)/s + 1;}
 };
 
+/// most domains are one or two ranges, these do not allocate
+using RangeVec = SmallVector<Range,2>;
+
 static_assert(std::numeric_limits<int32>::min()==-2147483648 && std::numeric_limits<int32>::max()==2147483647, "requires int to be 32bit and between -2147483648 .. 2147483647");
 
 class Restrictor;
@@ -57,6 +64,8 @@ class ViewDomain;
   Does overflow()==true if numbers get out of range
   Behaviour on calling a function on an overflown domain is undefined
   Can be empty
+  The ranges are sorted and their bounds do not overlap,
+  each range can have a stride, so multiplied domains stay small
 ****/
 class Domain
 {
@@ -80,7 +89,7 @@ public:
     /// create a domain [lower..upper]
     Domain(int32 lower, int32 upper) : ranges_{Range(lower,upper)}, size_(0), modified_(true), overflow_(false) { if (lower > upper) ranges_.clear(); }
 
-    const std::vector<Range>& getRanges() const { return ranges_; }
+    const RangeVec& getRanges() const { return ranges_; }
     bool overflow() const { return overflow_; }
 
     /// print a domain, short notation
@@ -100,9 +109,14 @@ public:
     /// returns true if domain is empty, false otherwise
     bool empty() const { return ranges_.size()==0 || ranges_.front().l>ranges_.back().u; }
 
-    bool operator==(const Domain& d) const { return ranges_ == d.ranges_; }
-    bool operator!=(const Domain& d) const { return ranges_ != d.ranges_; }
+    /// compares the elements, the same domain can be represented by different ranges
+    bool operator==(const Domain& d) const;
+    bool operator!=(const Domain& d) const { return !(*this==d); }
 
+    /// multiplies the domain elements by n if the size()
+    /// is below maxSize (-1 for always), otherwise
+    /// the bounds of the ranges are multiplied with n to get an overapproximation
+    /// pre: n!= 0
     Domain& inplace_times(int32 n, int64 maxSize);
 
     /// constrain all values i to fulfill: (times*i+c)%div==0
@@ -208,7 +222,7 @@ public:
             modified_=false;
             size_ = 0;
             for (auto i : ranges_)
-                size_ += (uint64)(((int64)(i.u)-(int64)(i.l))+1);
+                size_ += (uint64)(i.size());
         }
         return size_;
     }
@@ -273,8 +287,8 @@ public:
         friend ViewIterator lower_bound(ViewIterator, ViewIterator, int64);
         friend ViewIterator upper_bound(ViewIterator, ViewIterator, int64);
 
-        int32 operator*() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int(steps_); }
-        int32 operator->() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int(steps_); }
+        int32 operator*() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int64(steps_)*d_->ranges_[index_].s; }
+        int32 operator->() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int64(steps_)*d_->ranges_[index_].s; }
     private:
         const_iterator(Domain const* d, int index, int steps) : d_(d), index_(index), steps_(steps) {}
         Domain const * d_;
@@ -294,9 +308,9 @@ private:
 
     /// unify the domain with the [range],
     /// return iterator to a range where a bigger range can be inserted next time
-    std::vector<Range>::iterator add(std::vector<Range>::iterator start, const Range& r);
+    RangeVec::iterator add(RangeVec::iterator start, const Range& r);
 
-    std::vector<Range> ranges_;
+    RangeVec ranges_;
     mutable uint64 size_;
     mutable bool modified_;
     bool overflow_;
@@ -307,6 +321,8 @@ inline std::ostream& operator<< (std::ostream& stream, const Domain& d)
     for (auto i = d.ranges_.begin(); i != d.ranges_.end(); ++i)
     {
         stream << i->l << ".." << i->u;
+        if (i->s!=1)
+            stream << ":" << i->s;
         if (i+1!=d.ranges_.end())
             stream << ",";
     }
@@ -316,15 +332,21 @@ inline std::ostream& operator<< (std::ostream& stream, const Domain& d)
 
 
 
+/// the arithmetic progression l, l+s, l+2s, ..., u
+/// pre: (u-l)%s==0, s==1 if l==u
 class LongRange
 {
 public:
-    LongRange(int64 lower,int64 upper) : l(lower), u(upper) {}
-    bool operator==(const LongRange& d) const { return l==d.l && u==d.u; }
-    bool operator!=(const LongRange& d) const { return l!=d.l || u!=d.u; }
+    LongRange(int64 lower,int64 upper, int64 stride = 1) : l(lower), u(upper), s(stride) {}
+    bool operator==(const LongRange& d) const { return l==d.l && u==d.u && s==d.s; }
+    bool operator!=(const LongRange& d) const { return !(*this==d); }
     int64 l,u;
+    int64 s; /// the distance between two elements
+    uint64 size() const { return (uint64)(u - l)/s + 1;}
 };
 
+using LongRangeVec = SmallVector<LongRange,2>;
+
 /// special 64bit domain, created from Domain + View
 /// cant overflow, and only has simple functionality, except unify
 class ViewDomain
@@ -342,7 +364,7 @@ public:
     ViewDomain& operator=(const ViewDomain& d) = default;
     ViewDomain& operator=(ViewDomain&&) = default;
     ViewDomain(int64 lower, int64 upper) : ranges_{LongRange(lower,upper)} {}
-    ViewDomain(Domain d, View v)
+    ViewDomain(const Domain& d, View v)
     {
         int64 n = v.a;
         int64 c = v.c;
@@ -353,23 +375,18 @@ public:
             return;
         }
 
+        ranges_.reserve(d.ranges_.size());
         if (n<0)
         {
-            d.reverse();
-            n *= -1;
-        }
-        if (n==1)
-        {
-            for (auto r : d.ranges_)
-                ranges_.emplace_back(r.l+c,r.u+c);
-            return;
-        }
-
-        for (auto r: d.ranges_)
-            for (int64 i = r.l; i <= r.u; ++i)
+            for (std::size_t i = d.ranges_.size(); i-->0;)
             {
-                ranges_.emplace_back(i*n+c,i*n+c);
+                const Range& r = d.ranges_[i];
+                ranges_.emplace_back(r.u*n+c,r.l*n+c,r.l==r.u ? 1 : r.s*-n);
             }
+        }
+        else
+            for (const auto& r : d.ranges_)
+                ranges_.emplace_back(r.l*n+c,r.u*n+c,r.l==r.u ? 1 : r.s*n);
     }
 
 
@@ -417,7 +434,7 @@ public:
     {
         uint64 size = 0;
         for (auto i : ranges_)
-            size += (i.u-i.l)+1;
+            size += i.size();
         return size;
     }
 
@@ -480,8 +497,8 @@ public:
         const ViewDomain& getDomain() const { return *d_; }
 
 
-        int64 operator*() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int(steps_); }
-        int64 operator->() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int(steps_); }
+        int64 operator*() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int64(steps_)*d_->ranges_[index_].s; }
+        int64 operator->() const {assert(index_<d_->ranges_.size()); return d_->ranges_[index_].l+int64(steps_)*d_->ranges_[index_].s; }
     private:
         const_iterator(ViewDomain const* d, int index, uint64 steps) : d_(d), index_(index), steps_(steps) {}
         ViewDomain const * d_;
@@ -492,9 +509,9 @@ private:
 
     /// unify the domain with the [range],
     /// return iterator to a range where a bigger range can be inserted next time
-    std::vector<LongRange>::iterator add(std::vector<LongRange>::iterator start, const LongRange& r);
+    LongRangeVec::iterator add(LongRangeVec::iterator start, const LongRange& r);
 
-    std::vector<LongRange> ranges_;
+    LongRangeVec ranges_;
 };
 
 inline std::ostream& operator<< (std::ostream& stream, const ViewDomain& d)
@@ -502,6 +519,8 @@ inline std::ostream& operator<< (std::ostream& stream, const ViewDomain& d)
     for (auto i = d.ranges_.begin(); i != d.ranges_.end(); ++i)
     {
         stream << i->l << ".." << i->u;
+        if (i->s!=1)
+            stream << ":" << i->s;
         if (i+1!=d.ranges_.end())
             stream << ",";
     }
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <map>
 #include <cmath>
+#include <memory>
 
 
 #include <order/constraint.h>
@@ -40,38 +41,150 @@ namespace order
 class LinearPropagator;
 class LinearLiteralPropagator;
 
+/// normalized implications that can be shared read only between several propagators,
+/// e.g. one for each solver thread
+using SharedConstraints = std::shared_ptr<const std::vector<ReifiedLinearConstraint> >;
+/// alldistinct implications that can be shared read only between several propagators
+using SharedDistincts = std::shared_ptr<const std::vector<ReifiedAllDistinct> >;
+/// disjoint implications that can be shared read only between several propagators
+using SharedDisjoints = std::shared_ptr<const std::vector<ReifiedNormalizedDisjoint> >;
+
+/// counters of the lazy propagation queue
+/// with Config::sortQueue, bucket 0 holds constraints with an undecided literal,
+/// bucket i>0 true constraints with 2^(i-1) <= #views < 2^i, the last one is unbounded
+/// without Config::sortQueue, everything is in bucket 0
+struct QueueStats
+{
+    enum : unsigned int { numBuckets = 8 };
+    QueueStats() { std::fill(wakeups, wakeups+numBuckets, 0); std::fill(emptyWakeups, emptyWakeups+numBuckets, 0); }
+    QueueStats& operator+=(const QueueStats& other)
+    {
+        for (unsigned int i = 0; i < numBuckets; ++i)
+        {
+            wakeups[i] += other.wakeups[i];
+            emptyWakeups[i] += other.emptyWakeups[i];
+        }
+        return *this;
+    }
+    uint64 wakeups[numBuckets]; /// number of constraints taken from each bucket
+    uint64 emptyWakeups[numBuckets]; /// number of those that did not propagate anything
+};
+
 /// weird interface
 class ConstraintStorage
 {
 private:
-    ConstraintStorage(const Config& conf) : conf_(conf) {}
+    ConstraintStorage(const Config& conf, const VariableStorage& vs, const Solver& s) :
+        vs_(vs), s_(s), own_(std::make_shared<std::vector<ReifiedLinearConstraint> >()), constraints_(own_), queued_(0), lastBucket_(0), conf_(conf) {}
     friend LinearPropagator;
     friend LinearLiteralPropagator;
     /// add an implication constraint l.v -> l.l
+    /// constraints have to be added on the top level
     void addImp(ReifiedLinearConstraint&& l);
     /// add several implication constraints l.v -> l.l
     void addImp(std::vector<ReifiedLinearConstraint>&& l);
     // add several implication constraints l.v -> l.l
     void addImp(const std::vector<ReifiedLinearConstraint>& l);
+    /// add several normalized implication constraints l.v -> l.l,
+    /// they are not copied if there are no other constraints
+    void addImp(const SharedConstraints& l);
+    /// replaces the constraints by l, which starts with the current constraints,
+    /// and adds the remaining ones
+    /// pre: on the top level
+    void extendImp(const SharedConstraints& l);
     /// remove all constraints,
     /// moves the list of all reified implications out of the object
     std::vector<ReifiedLinearConstraint> removeConstraints();
-    void addLevel() { assert(toProcess_.empty()); }
+    void addLevel() { assert(atFixPoint()); levels_.emplace_back(activityTrail_.size(), removedWatches_.size()); }
     void removeLevel();
     /// true if we are at a fixpoint
-    bool atFixPoint() { return toProcess_.empty(); }
-    /// return false if the domain is empty
-    void constrainUpperBound(const View &view, const Solver &s);
-    void constrainLowerBound(const View &view, const Solver &s);
+    bool atFixPoint() { return queued_ == 0; }
+    /// queues all constraints that can propagate because of the new upper bound of view
+    /// and updates their activities, old and now are the variable restrictors
+    /// before and after the change
+    void constrainUpperBound(const View &view, const Restrictor& old, const Restrictor& now);
+    void constrainLowerBound(const View &view, const Restrictor& old, const Restrictor& now);
+    /// queues all constraints that can propagate because the lower bound of v changed by dl
+    /// and the upper bound by du, and updates their activities
+    void changeBounds(Variable v, int64 dl, int64 du);
+    /// queues the constraints whose literal was undecided when they were added
+    /// and became true in the meantime
+    void wakeDecided();
     void queueConstraint(std::size_t id);
+    /// returns the constraint from the cheapest non empty bucket
     std::size_t popConstraint();
+    /// the constraint last returned by popConstraint did not propagate anything
+    void emptyWakeup() { ++stats_.emptyWakeups[lastBucket_]; }
+    /// the minimum and maximum of the lhs of constraint id under the current bounds
+    const std::pair<int64,int64>& activity(std::size_t id) const { return activities_[id]; }
+    const ReifiedLinearConstraint& constraint(std::size_t id) const { return (*constraints_)[id]; }
+    const std::vector<ReifiedLinearConstraint>& constraints() const { return *constraints_; }
 private:
-    /// a list of all constraints
-    std::vector<ReifiedLinearConstraint> linearImpConstraints_;
-    std::vector<std::size_t> toProcess_; // a list of constraints that need to be processed
-    // a list of constraints that have to be processed if the bound of the variable changes and the constraint is TRUE (opposite case for false, and dont care for unknown)
-    std::vector<std::vector<std::size_t> > lbChanges_;
-    std::vector<std::vector<std::size_t> > ubChanges_;
+    /// the constraints that can be changed, copies them if they are shared
+    std::vector<ReifiedLinearConstraint>& ownConstraints();
+    /// creates watches, activity and queue entries for a new constraint
+    void initConstraint(std::size_t id);
+    /// computes the min/maximum of the lhs
+    std::pair<int64,int64> computeMinMax(const LinearConstraint& l) const;
+    /// change the activity of constraint id, the old one is restored on removeLevel
+    void updateActivity(std::size_t id, int64 dmin, int64 dmax);
+    /// the watch lists for a lower (upper=false) or upper (upper=true) bound change of variable v
+    static std::size_t watchIndex(Variable v, bool upper) { return 2*std::size_t(v) + upper; }
+    /// clear the queue and unflag the constraints in it
+    void clearQueue();
+    /// queue the constraints in the list that are not false and update their minimum by a*d,
+    /// constraints with a false literal are removed until the level is removed
+    void wakeReified(std::size_t index, int64 d);
+
+    /// a constraint watching a variable, a is the coefficient of the variable in the constraint
+    struct Watch
+    {
+        Watch(std::size_t id, int32 a) : id(id), a(a) {}
+        std::size_t id;
+        int32 a;
+    };
+
+    /// a watch that was removed from reifWatches_[index]
+    struct RemovedWatch
+    {
+        RemovedWatch(std::size_t index, const Watch& w) : index(index), w(w) {}
+        std::size_t index;
+        Watch w;
+    };
+
+    struct ActivityTrailEntry
+    {
+        ActivityTrailEntry(std::size_t id, uint32 level, const std::pair<int64,int64>& activity) : id(id), level(level), activity(activity) {}
+        std::size_t id;
+        uint32 level;
+        std::pair<int64,int64> activity;
+    };
+
+    const VariableStorage& vs_;
+    const Solver& s_;
+    /// a list of all constraints, may be shared read only with other storages
+    /// own_ is the same list if it is not shared, nullptr otherwise
+    std::shared_ptr<std::vector<ReifiedLinearConstraint> > own_;
+    SharedConstraints constraints_;
+    std::vector<bool> queuedFlags_; /// for each constraint, true if it is in one of the buckets
+    std::vector<std::size_t> toProcess_[QueueStats::numBuckets]; // lists of constraints that need to be processed
+    std::size_t queued_; /// number of constraints in all buckets
+    std::vector<unsigned char> sizeBucket_; /// for each constraint, the bucket if it is true
+    std::vector<bool> reified_; /// for each constraint, true if its literal was not true on the top level
+    std::vector<std::size_t> undecided_; /// constraints whose literal was undecided at the last wakeDecided
+    unsigned int lastBucket_; /// bucket of the last popped constraint
+    QueueStats stats_;
+    /// watch lists indexed by watchIndex(variable, direction of the bound change)
+    /// only constraints whose minimum increases can propagate, the ones that are true on the top level
+    /// are in propWatches_, the reified ones in reifWatches_, the ones whose maximum decreases in actWatches_
+    std::vector<std::vector<Watch> > propWatches_;
+    std::vector<std::vector<Watch> > reifWatches_;
+    std::vector<std::vector<Watch> > actWatches_;
+    std::vector<RemovedWatch> removedWatches_; /// reified watches of false constraints, restored on removeLevel
+    std::vector<std::pair<int64,int64> > activities_; /// for each constraint, the min/maximum of the lhs
+    std::vector<ActivityTrailEntry> activityTrail_; /// undo trail, each activity is stored at most once per level
+    std::vector<std::pair<std::size_t,std::size_t> > levels_; /// for each level, the size of activityTrail_ and removedWatches_ when the level was added
+    std::vector<uint32> stamps_; /// for each constraint, the level on which its activity was last stored on the trail
     Config conf_;
 };
 
@@ -80,7 +193,7 @@ class LinearPropagator
 {
 public:
     LinearPropagator(CreatingSolver& s, const VariableCreator& vc, const Config& conf) :
-        storage_(conf), s_(s), vs_(vc,s.trueLit()), propagated_(false) {}
+        s_(s), vs_(vc,s.trueLit()), storage_(conf,vs_,s_), propagated_(false) { saveBounds(); }
 
     CreatingSolver& getSolver() { return s_; }
 
@@ -99,11 +212,20 @@ public:
     /// propagates some literals using a creatingSolver
     bool propagate();
 
+    /// the domains of the VariableCreator have been restricted in place since the last fixpoint,
+    /// e.g. by writing back the propagated bounds or by the literals of the master solver,
+    /// rebases the variables onto them and queues only the constraints watching changed bounds
+    /// and the ones whose literal became true, the next propagate call continues from there
+    /// pre: no level has been added
+    /// return false if a domain gets empty
+    bool domainsChanged();
+
     /// return true if last propagate call did add
     /// nogoods that imply a constraint literal
     bool propagated() const;
 
     const VariableStorage& getVariableStorage() const { return vs_; }
+    const QueueStats& stats() const { return storage_.stats_; }
 private:
 
     /// return false if the domain is empty
@@ -113,25 +235,27 @@ private:
     /// return false if a domain gets empty
     bool propagateSingleStep();
 
-    /// computes the min/maximum of the lhs
-    std::pair<int64,int64> computeMinMax(const LinearConstraint& l);
-
     /// propagates directly, thinks the constraint is true
     /// can result in an empty domain, if so it returns false
     /// can only handle LE constraints
     /// DOES NOT GUARANTEE A FIXPOINT (just not sure)(but reshedules if not)
     /// Remarks: uses double for floor/ceil -> to compatible with 64bit integers
-    bool propagate_true(const LinearConstraint& l);
+    bool propagate_true(const LinearConstraint& l, std::size_t id);
 
     /// propagates the truthvalue of the constraint if it can be directly inferred
     /// can only handle LE constraints
-    bool propagate_impl(ReifiedLinearConstraint &rl);
+    bool propagate_impl(const ReifiedLinearConstraint &rl, std::size_t id);
+
+    /// stores the bounds of all variables, the restrictors can not be read
+    /// anymore once the domains are changed in place
+    void saveBounds();
 private:
 
-    ConstraintStorage storage_;
     CreatingSolver& s_;
     VariableStorage vs_;
+    ConstraintStorage storage_;
     bool propagated_;
+    std::vector<std::pair<int64,int64> > bounds_; /// for each variable, the bounds at the last fixpoint
 };
 
 
@@ -147,7 +271,9 @@ public:
 
 public:
     LinearLiteralPropagator(IncrementalSolver& s, const VariableCreator& vs, const Config& conf) :
-        storage_(conf), s_(s), vs_(vs, s.trueLit()), conf_(conf) {}
+        s_(s), vs_(vs, s.trueLit()), storage_(conf, vs_.getVariableStorage(), s_), propId_(0), propDistinct_(false), propDisjoint_(false),
+        distincts_(std::make_shared<const std::vector<ReifiedAllDistinct> >()),
+        disjoints_(std::make_shared<const std::vector<ReifiedNormalizedDisjoint> >()), conf_(conf) {}
 
     IncrementalSolver& getSolver() { return s_; }
     VolatileVariableStorage& getVVS() { return vs_; }
@@ -157,18 +283,46 @@ public:
     void addImp(ReifiedLinearConstraint&& l) { storage_.addImp(std::move(l)); }
     /// add several implication constraints l.v -> l.l
     void addImp(const std::vector<ReifiedLinearConstraint>& l) { storage_.addImp(l); }
+    /// add several normalized implication constraints l.v -> l.l, shared with other propagators
+    void addImp(const SharedConstraints& l) { storage_.addImp(l); }
+    /// replaces the shared constraints by l, which starts with the current constraints,
+    /// only the new ones at the end are added, for incremental solving
+    /// pre: on the top level, the domains of the old variables did not change
+    void extendImp(const SharedConstraints& l) { storage_.extendImp(l); }
     /// remove all constraints,
     /// moves the list of all reified implications out of the object
     std::vector<ReifiedLinearConstraint> removeConstraints() { return storage_.removeConstraints(); }
-    const std::vector<ReifiedLinearConstraint>& constraints() { return storage_.linearImpConstraints_; }
+    const std::vector<ReifiedLinearConstraint>& constraints() const { return storage_.constraints(); }
+    /// add normalized alldistinct implications l.v -> distinct(l.views), shared with other propagators
+    /// pre: on the top level, can only be called once, before addDisjoints
+    void addDistincts(const SharedDistincts& l);
+    const std::vector<ReifiedAllDistinct>& distincts() const { return *distincts_; }
+    /// add disjoint implications l.v -> disjoint(l.views), shared with other propagators
+    /// pre: on the top level, can only be called once
+    void addDisjoints(const SharedDisjoints& l);
+    const std::vector<ReifiedNormalizedDisjoint>& disjoints() const { return *disjoints_; }
     void addLevel() { storage_.addLevel(); vs_.getVariableStorage().addLevel();}
-    void removeLevel() {storage_.removeLevel(); vs_.getVariableStorage().removeLevel();}
+    void removeLevel() { storage_.removeLevel(); clearGlobalQueue(); vs_.getVariableStorage().removeLevel();}
 
     /// true if we are at a fixpoint, propagateSingleStep does not do anything anymore
-    bool atFixPoint() { return storage_.atFixPoint(); }
+    bool atFixPoint() { return storage_.atFixPoint() && globalQueue_.empty(); }
+    const QueueStats& stats() const { return storage_.stats_; }
     /// the same but generates a set of reasons
     /// reference is valid until the next call of propagateSingleStep
     std::vector<LinearConstraintClause>& propagateSingleStep();
+    /// the constraint that generated the clauses of the last propagateSingleStep call,
+    /// the iterators of the clauses are in the same order as its views
+    std::size_t propagatedConstraint() const { return propId_; }
+    /// true if the clauses of the last propagateSingleStep call were generated by
+    /// the alldistinct constraint distincts()[propagatedConstraint()]
+    bool propagatedDistinct() const { return propDistinct_; }
+    /// true if the clauses of the last propagateSingleStep call were generated by
+    /// the disjoint constraint disjoints()[propagatedConstraint()]
+    bool propagatedDisjoint() const { return propDisjoint_; }
+    /// the condition literals of the i-th clause of the last propagateSingleStep call,
+    /// they belong to the clause in addition to its first literal
+    /// pre: propagatedDisjoint()
+    const LitVec& clauseConditions(std::size_t i) const { return propConditions_[i]; }
     /// propagate all added constraints to a fixpoint
     /// return false if a domain gets empty
     bool propagate();
@@ -181,33 +335,67 @@ public:
 
     /// add a constraint (identified by id) to the propagation queue
     void queueConstraint(std::size_t id) { storage_.queueConstraint(id); }
+    /// add an alldistinct constraint (identified by id) to the propagation queue
+    void queueDistinct(std::size_t id) { queueGlobal(id); }
+    /// add a disjoint constraint (identified by id) to the propagation queue
+    void queueDisjoint(std::size_t id) { queueGlobal(distincts_->size()+id); }
 
     //VariableStorage& getVariableStorage() { return vs_; }
 
 private:
 
-    /// computes the min/maximum of the lhs
-    std::pair<int64,int64> computeMinMax(const LinearConstraint& l, itervec &clause);
-    int64 computeMin(const LinearConstraint& l, itervec& clause);
+    /// collects the current lower bounds of the lhs as reason
+    void computeReason(const LinearConstraint& l, itervec &clause);
 
     /// propagates directly, thinks the constraint is true
     /// can result in an empty domain, if so it returns false
     /// can only handle LE constraints
     /// DOES NOT GUARANTEE A FIXPOINT (just not sure)(but reshedules if not)
     /// Remarks: uses double for floor/ceil -> to compatible with 64bit integers
-    void propagate_true(const ReifiedLinearConstraint& l);
+    void propagate_true(const ReifiedLinearConstraint& l, std::size_t id);
 
     /// propagates the truthvalue of the constraint if it can be directly inferred
     /// can only handle LE constraints
-    void propagate_impl(ReifiedLinearConstraint &rl);
+    void propagate_impl(const ReifiedLinearConstraint &rl, std::size_t id);
+
+    /// bounds consistent propagation of an alldistinct constraint using Hall intervals,
+    /// if the literal is not true, only a conflict is detected which makes it false
+    /// stops after the first Hall interval that propagates something (reshedules itself by changing bounds)
+    void propagateDistinct(const ReifiedAllDistinct& d);
+    /// propagates a disjoint constraint on the bounds of its views,
+    /// a view with a true condition that is fixed to a value removes this value
+    /// from the bounds of the views of all other groups (or makes their condition false),
+    /// if the literal is not true, only a conflict is detected which makes it false
+    void propagateDisjoint(const ReifiedNormalizedDisjoint& d);
+    /// alldistinct constraints have the ids [0,distincts_->size()), disjoint constraints follow
+    void queueGlobal(std::size_t id);
+    /// queue all alldistinct and disjoint constraints of variable v
+    void wakeGlobals(Variable v);
+    void clearGlobalQueue();
+    /// adds a globally identified constraint to the watch list of v
+    void addGlobalWatch(Variable v, std::size_t id);
+    /// adds the reason that view is within its current bounds to clause
+    void addBoundsReason(const View& view, itervec& clause);
 
 
 private:
-    ConstraintStorage storage_;
     IncrementalSolver& s_;
     VolatileVariableStorage vs_;
+    ConstraintStorage storage_;
     itervec propClause_;
     std::vector<LinearLiteralPropagator::LinearConstraintClause> propClauses_; /// temp variable for generatedclauses
+    std::size_t propId_; /// the constraint that generated propClauses_
+    bool propDistinct_; /// propId_ refers to an alldistinct constraint
+    bool propDisjoint_; /// propId_ refers to a disjoint constraint
+    std::vector<LitVec> propConditions_; /// for disjoint constraints, the conditions of each clause in propClauses_
+    SharedDistincts distincts_;
+    SharedDisjoints disjoints_;
+    std::vector<std::vector<std::size_t> > globalWatches_; /// for each variable, the alldistinct and disjoint constraints it occurs in
+    std::vector<std::size_t> globalQueue_;
+    std::vector<bool> globalQueued_;
+    std::vector<std::pair<int64,int64> > distinctBounds_; /// temp variable, the current bounds of the views
+    std::vector<std::size_t> distinctOrder_; /// temp variable, the views sorted by upper bound
+    std::vector<std::pair<int64,std::pair<std::size_t,std::size_t> > > fixedViews_; /// temp variable, value, group and index of fixed disjoint views
     Config conf_;
 };
 
@@ -37,8 +37,13 @@ namespace order
 class Normalizer
 {
 public:
-    Normalizer(CreatingSolver& s, Config conf) : s_(s), vc_(s, conf), conf_(conf), ep_(s_,vc_), firstRun_(true),
-    varsBefore_(0), varsAfter_(0), varsAfterFinalize_(0) {}
+    Normalizer(CreatingSolver& s, Config conf) : constraintEpoch_(0), s_(s), vc_(s, conf), conf_(conf), ep_(s_,vc_), firstRun_(true),
+    varsBefore_(0), varsAfter_(0), varsAfterFinalize_(0)
+    {
+        sharedConstraints_ = std::make_shared<const std::vector<ReifiedLinearConstraint> >();
+        sharedDistincts_ = std::make_shared<const std::vector<ReifiedAllDistinct> >();
+        sharedDisjoints_ = std::make_shared<const std::vector<ReifiedNormalizedDisjoint> >();
+    }
 
     /// can be made const, only changed for unit tests
     Config& getConfig()
@@ -48,7 +53,7 @@ public:
 
     /// to create view with an already existing variable, just use View manually
     View createView() { return View(vc_.createVariable()); }
-    View createView(const Domain& d) { return View(vc_.createVariable(d)); }
+    View createView(Domain d) { return View(vc_.createVariable(std::move(d))); }
 
     /// adds a constraint to the propagator l.v <-> l.l
     /// returns false on unsat
@@ -75,24 +80,61 @@ public:
     /// returns two lists of variables that do not have lower or upper bounds
     void variablesWithoutBounds(std::vector<order::Variable>& lb, std::vector<order::Variable>& ub);
 
-    /// converts some of the aux literals in the VVS's into normal once
-    /// numVars must be the biggest+1 boolean variable used in all order::Literals so far,
-    /// sucht that the test l.var() < numVars is true for all "normal" variables
-    /// and false for all aux variables
-    void convertAuxLiterals(std::vector<const order::VolatileVariableStorage*>& vvs, unsigned int numVars);
-
-    /// a reference to all linear implications
-    /// pre: prepare and createClauses must have been called
-    std::vector<ReifiedLinearConstraint>& constraints()
+    /// the order literals created lazily by the solver threads during the current solve step
+    /// reset by finalize, which also fills its pool with conf.sharedLazyLiterals free literals
+    LazyLiteralRegistry& lazyLiterals() { return lazyLiterals_; }
+
+    /// the pool literals of the lazyLiterals() registry that stand for a bound become its order literals,
+    /// the other ones are made false
+    /// creates normal literals for the other lazily created literals of the registry,
+    /// such that all threads share them in the next solve step
+    /// with conf.convertLazy.second, all literals created by at least one thread are converted (union),
+    /// otherwise only those that were created by all numThreads threads (intersection)
+    /// returns false if addclause fails
+    bool convertLazyLiterals(unsigned int numThreads);
+
+    /// how often the lazily propagated constraints of sharedConstraints() produced nogoods
+    /// during the current solve step, reset by finalize
+    ConstraintActivity& constraintActivity() { return activity_; }
+
+    /// translates the lazy constraints that produced nogoods at least conf.translateHot.second times,
+    /// the most active ones first, as long as their estimated nogoods fit into conf.translateHot.first,
+    /// the translated constraints are removed from sharedConstraints() for the next solve step
+    /// returns false if addclause fails
+    bool translateHotConstraints();
+
+    /// a reference to all linear implications of all steps that are left to the propagators,
+    /// the same list as sharedConstraints()
+    /// pre: finalize must have been called
+    const std::vector<ReifiedLinearConstraint>& constraints() const
     {
-        for (auto& i : linearConstraints_)
+        for (auto& i : *sharedConstraints_)
         {
             assert(i.impl == Direction::FWD);
             ((void)(i));
         }
-        return linearConstraints_;
+        return *sharedConstraints_;
     }
 
+    /// a read only copy of all normalized linear implications,
+    /// to be shared between all solver threads
+    /// empty until finalize has been called successfully
+    /// each finalize appends the implications of its step, so the propagators
+    /// of the previous step can be extended as long as constraintEpoch() did not change
+    const SharedConstraints& sharedConstraints() const { return sharedConstraints_; }
+
+    /// changes whenever sharedConstraints() is changed in another way than by appending
+    uint64 constraintEpoch() const { return constraintEpoch_; }
+
+    /// a read only copy of all alldistinct implications that are not translated
+    /// but left to the propagator (Config::alldistinctProp)
+    /// empty until finalize has been called successfully, only replaced if a step added some
+    const SharedDistincts& sharedDistincts() const { return sharedDistincts_; }
+
+    /// a read only copy of all disjoint implications left to the propagator (Config::disjointProp)
+    /// empty until finalize has been called successfully, only replaced if a step added some
+    const SharedDisjoints& sharedDisjoints() const { return sharedDisjoints_; }
+
     VariableCreator& getVariableCreator() { return vc_; }
     const VariableCreator& getVariableCreator() const { return vc_; }
 
@@ -184,12 +226,17 @@ public:
     /// add constraint l as implications to vector insert
     bool convertLinear(ReifiedLinearConstraint&& l, std::vector<ReifiedLinearConstraint> &insert);
     bool addDomainConstraint(ReifiedDomainConstraint&& l);
+    /// true if v takes no value between the elements of the progression r,
+    /// so that the bounds of r are enough to encode it
+    bool onlyProgression(const View& v, const Range& r);
     bool addDistinct(ReifiedAllDistinct&& l);
     bool addPidgeonConstraint(ReifiedAllDistinct& l);
     bool addPermutationConstraint(ReifiedAllDistinct& l);
     bool addDistinctPairwiseUnequal(ReifiedAllDistinct&& l);
     //bool addDistinctHallIntervals(ReifiedAllDistinct&& l);
     bool addDistinctCardinality(ReifiedAllDistinct&& l);
+    /// keeps the implication for the alldistinct propagator
+    bool addDistinctPropagator(ReifiedAllDistinct&& l);
     bool addDisjoint(ReifiedDisjoint &&l);
 
     void addMinimize();
@@ -214,8 +261,16 @@ public:
     /// a list of all constraints
     //std::vector<ReifiedLinearConstraint> linearImplications_;  /// normalized LE implications
 
-    std::vector<ReifiedLinearConstraint> linearConstraints_;
+    std::vector<ReifiedLinearConstraint> linearConstraints_; /// the constraints of the current step
+    SharedConstraints sharedConstraints_; /// normalized implications of all finalized steps left to the propagators
+    uint64 constraintEpoch_;
+    LazyLiteralRegistry lazyLiterals_;
+    ConstraintActivity activity_; /// counts of the propagated nogoods for sharedConstraints_
     std::vector<ReifiedAllDistinct> allDistincts_;
+    std::vector<ReifiedAllDistinct> propagatedDistincts_; /// FWD implications handled by the alldistinct propagator
+    SharedDistincts sharedDistincts_; /// copy of propagatedDistincts_ after finalize
+    std::vector<ReifiedNormalizedDisjoint> propagatedDisjoints_; /// FWD implications handled by the disjoint propagator
+    SharedDisjoints sharedDisjoints_; /// copy of propagatedDisjoints_ after finalize
     std::vector<ReifiedDomainConstraint> domainConstraints_;
     std::vector<ReifiedDisjoint> disjoints_;
     std::vector<std::pair<View,unsigned int> > minimize_; /// Views on a level to minimize
@@ -0,0 +1,207 @@
+// {{{ MIT License
+
+// Copyright 2017 Max Ostrowski
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// }}}
+
+#pragma once
+#include <order/types.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace order
+{
+
+/// a vector that stores up to N elements inline, without allocating memory
+/// only for trivially copyable types, elements are moved bytewise
+template<class T, std::size_t N>
+class SmallVector
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector requires trivially copyable elements");
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+
+    SmallVector() : data_(buffer()), size_(0), capacity_(N) {}
+    SmallVector(std::initializer_list<T> l) : SmallVector() { insert(end(), l.begin(), l.end()); }
+    SmallVector(const SmallVector& v) : SmallVector() { insert(end(), v.begin(), v.end()); }
+    SmallVector(SmallVector&& v) : SmallVector() { steal(v); }
+    ~SmallVector() { release(); }
+
+    SmallVector& operator=(const SmallVector& v)
+    {
+        if (this != &v)
+        {
+            clear();
+            insert(end(), v.begin(), v.end());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& v)
+    {
+        if (this != &v)
+        {
+            release();
+            data_ = buffer();
+            size_ = 0;
+            capacity_ = N;
+            steal(v);
+        }
+        return *this;
+    }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_+size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_+size_; }
+
+    size_type size() const { return size_; }
+    bool empty() const { return size_==0; }
+    size_type capacity() const { return capacity_; }
+    /// returns true if the elements are stored inline
+    bool isInline() const { return data_==buffer(); }
+
+    T& operator[](size_type i) { assert(i<size_); return data_[i]; }
+    const T& operator[](size_type i) const { assert(i<size_); return data_[i]; }
+    T& front() { assert(size_); return data_[0]; }
+    const T& front() const { assert(size_); return data_[0]; }
+    T& back() { assert(size_); return data_[size_-1]; }
+    const T& back() const { assert(size_); return data_[size_-1]; }
+
+    void clear() { size_ = 0; }
+    void reserve(size_type n) { if (n > capacity_) grow(n); }
+
+    void push_back(const T& x) { emplace_back(x); }
+
+    template<class... Args>
+    void emplace_back(Args&&... args)
+    {
+        T x(std::forward<Args>(args)...); /// args may refer to an element
+        if (size_==capacity_)
+            grow(capacity_*2);
+        new (data_+size_) T(x);
+        ++size_;
+    }
+
+    iterator insert(const_iterator pos, const T& x)
+    {
+        T y(x); /// x may refer to an element
+        size_type i = pos - data_;
+        if (size_==capacity_)
+            grow(capacity_*2);
+        std::memmove(static_cast<void*>(data_+i+1), data_+i, (size_-i)*sizeof(T));
+        new (data_+i) T(y);
+        ++size_;
+        return data_+i;
+    }
+
+    /// pre: [first,last) does not refer to this vector
+    template<class It>
+    iterator insert(const_iterator pos, It first, It last)
+    {
+        size_type i = pos - data_;
+        size_type n = std::distance(first,last);
+        if (size_+n > capacity_)
+            grow(std::max(size_+n,(size_type)(capacity_)*2));
+        std::memmove(static_cast<void*>(data_+i+n), data_+i, (size_-i)*sizeof(T));
+        for (T* out = data_+i; first != last; ++first, ++out)
+            new (out) T(*first);
+        size_ += n;
+        return data_+i;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos,pos+1); }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type i = first - data_;
+        size_type n = last - first;
+        std::memmove(static_cast<void*>(data_+i), data_+i+n, (size_-i-n)*sizeof(T));
+        size_ -= n;
+        return data_+i;
+    }
+
+    void swap(SmallVector& v)
+    {
+        SmallVector t(std::move(v));
+        v = std::move(*this);
+        *this = std::move(t);
+    }
+
+    bool operator==(const SmallVector& v) const { return size_==v.size_ && std::equal(begin(),end(),v.begin()); }
+    bool operator!=(const SmallVector& v) const { return !(*this==v); }
+
+private:
+    T* buffer() { return reinterpret_cast<T*>(&inline_); }
+    const T* buffer() const { return reinterpret_cast<const T*>(&inline_); }
+
+    void grow(size_type n)
+    {
+        T* d = static_cast<T*>(std::malloc(n*sizeof(T)));
+        if (!d)
+            throw std::bad_alloc();
+        std::memcpy(static_cast<void*>(d), data_, size_*sizeof(T));
+        release();
+        data_ = d;
+        capacity_ = n;
+    }
+
+    void release()
+    {
+        if (!isInline())
+            std::free(data_);
+    }
+
+    /// pre: this is empty and inline
+    void steal(SmallVector& v)
+    {
+        if (v.isInline())
+            std::memcpy(static_cast<void*>(data_), v.data_, v.size_*sizeof(T));
+        else
+        {
+            data_ = v.data_;
+            capacity_ = v.capacity_;
+            v.data_ = v.buffer();
+            v.capacity_ = N;
+        }
+        size_ = v.size_;
+        v.size_ = 0;
+    }
+
+    T* data_;
+    uint32 size_;
+    uint32 capacity_;
+    typename std::aligned_storage<sizeof(T)*N, alignof(T)>::type inline_;
+};
+
+}
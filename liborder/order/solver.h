@@ -24,6 +24,7 @@
 
 #pragma once
 #include <vector>
+#include <initializer_list>
 #include <ostream>
 #include <cassert>
 #include <order/platform.h>
@@ -145,6 +146,11 @@ private:
 
 using LitVec = std::vector<Literal>;
 
+/// marks the end of a clause in a flat clause buffer,
+/// it is never a literal of a clause
+inline Literal clauseEnd() { Literal l(0,false); l.flag(); return l; }
+inline bool isClauseEnd(const Literal& l) { return l.asUint()==clauseEnd().asUint(); }
+
 
 class Solver
 {
@@ -183,6 +189,26 @@ public:
 
     virtual bool createClause(const LitVec &) = 0;
 
+    /// create all clauses of a flat buffer, each clause is terminated by clauseEnd()
+    /// returns false if a clause is conflicting
+    /// the default creates them one by one with createClause
+    virtual bool createClauses(const LitVec& clauses)
+    {
+        LitVec clause;
+        for (auto l : clauses)
+        {
+            if (!isClauseEnd(l))
+            {
+                clause.emplace_back(l);
+                continue;
+            }
+            if (!createClause(clause))
+                return false;
+            clause.clear();
+        }
+        return true;
+    }
+
     /// create a simple cardinality constraint v =:= lb {lits}
     virtual bool createCardinality(Literal v, int lb, LitVec&& lits) = 0;
 
@@ -197,6 +223,41 @@ public:
 };
 
 
+/// collects clauses in a flat buffer and creates them in bulk with CreatingSolver::createClauses
+/// a conflict is only reported by the add that flushes the buffer or by flush,
+/// clauses that are not flushed are dropped, e.g. after a conflict
+class ClauseBuffer
+{
+public:
+    ClauseBuffer(CreatingSolver& s, std::size_t limit = 1 << 16) : s_(s), limit_(limit) {}
+
+    /// add a clause, creates all buffered clauses if the buffer is full
+    bool add(std::initializer_list<Literal> c) { return add(c.begin(), c.end()); }
+    bool add(const LitVec& c) { return add(c.begin(), c.end()); }
+    template<typename It>
+    bool add(It begin, It end)
+    {
+        buffer_.insert(buffer_.end(), begin, end);
+        buffer_.emplace_back(clauseEnd());
+        return buffer_.size() < limit_ || flush();
+    }
+
+    /// create all buffered clauses
+    /// returns false if a clause is conflicting
+    bool flush()
+    {
+        if (buffer_.empty())
+            return true;
+        bool ret = s_.createClauses(buffer_);
+        buffer_.clear();
+        return ret;
+    }
+private:
+    CreatingSolver& s_;
+    std::size_t limit_;
+    LitVec buffer_;
+};
+
 
 inline std::ostream& operator<< (std::ostream& stream, const Literal& l)
 {
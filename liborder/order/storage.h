@@ -36,6 +36,11 @@
 #include <map>
 #include <unordered_map>
 #include <cmath>
+#include <atomic>
+#include <limits>
+#include <iterator>
+#include <cstddef>
+#include <algorithm>
 
 
 namespace order
@@ -50,23 +55,134 @@ class pure_LELiteral_iterator;
 
 
 
+/// sparse storage of order literals, sorted by their index
+/// the entries are kept in contiguous sorted chunks of at most maxChunk entries,
+/// the chunk of an index is found by a binary search over the first index of each chunk,
+/// so lookups are O(log n) and an insertion only moves the entries of one chunk
+class SparseLitMap
+{
+public:
+    using value_type = std::pair<unsigned int, Literal>;
+    static const std::size_t maxChunk = 256;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = SparseLitMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        friend SparseLitMap;
+        const_iterator() : m_(nullptr), chunk_(0), pos_(0) {}
+
+        const value_type& operator*() const { return m_->chunks_[chunk_][pos_]; }
+        const value_type* operator->() const { return &m_->chunks_[chunk_][pos_]; }
+
+        const_iterator& operator++()
+        {
+            if (++pos_ == m_->chunks_[chunk_].size())
+            {
+                ++chunk_;
+                pos_ = 0;
+            }
+            return *this;
+        }
+        const_iterator& operator--()
+        {
+            if (pos_ == 0)
+            {
+                --chunk_;
+                pos_ = m_->chunks_[chunk_].size();
+            }
+            --pos_;
+            return *this;
+        }
+        const_iterator operator++(int) { const_iterator tmp(*this); operator++(); return tmp; }
+        const_iterator operator--(int) { const_iterator tmp(*this); operator--(); return tmp; }
+
+        // please do only compare iterators of the same map
+        bool operator==(const const_iterator& x) const { return chunk_ == x.chunk_ && pos_ == x.pos_; }
+        bool operator!=(const const_iterator& x) const { return !(*this == x); }
+    private:
+        const_iterator(const SparseLitMap* m, std::size_t chunk, std::size_t pos) : m_(m), chunk_(chunk), pos_(pos) {}
+        const SparseLitMap* m_;
+        std::size_t chunk_;
+        std::size_t pos_;
+    };
+
+    SparseLitMap() : size_(0) {}
+
+    const_iterator begin() const { return const_iterator(this,0,0); }
+    const_iterator end() const { return const_iterator(this,chunks_.size(),0); }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_==0; }
+    void clear() { chunks_.clear(); firsts_.clear(); size_=0; }
+    void swap(SparseLitMap& m) { chunks_.swap(m.chunks_); firsts_.swap(m.firsts_); std::swap(size_,m.size_); }
+
+    /// returns the first entry with an index >= index
+    const_iterator lower_bound(unsigned int index) const
+    {
+        if (chunks_.empty())
+            return end();
+        std::size_t c = chunkOf(index);
+        const auto& ch = chunks_[c];
+        auto it = std::lower_bound(ch.begin(), ch.end(), index, [](const value_type& v, unsigned int i) { return v.first < i; });
+        if (it == ch.end())
+            return const_iterator(this,c+1,0);
+        return const_iterator(this,c,it-ch.begin());
+    }
+
+    const_iterator find(unsigned int index) const
+    {
+        auto it = lower_bound(index);
+        return (it != end() && it->first == index) ? it : end();
+    }
+
+    /// inserts v if there is no entry with the same index
+    /// returns the entry with the index of v and true if it was inserted
+    std::pair<const_iterator,bool> insert(const value_type& v);
+    std::pair<const_iterator,bool> emplace(unsigned int index, const Literal& l) { return insert(value_type(index,l)); }
+
+    /// returns the entry after the erased one
+    const_iterator erase(const_iterator it);
+
+private:
+    /// the chunk which would contain index, 0 if index is before all chunks
+    /// pre: !chunks_.empty()
+    std::size_t chunkOf(unsigned int index) const
+    {
+        auto it = std::upper_bound(firsts_.begin(), firsts_.end(), index);
+        return it == firsts_.begin() ? 0 : (it - firsts_.begin()) - 1;
+    }
+
+    std::vector<std::vector<value_type> > chunks_; /// never empty chunks
+    std::vector<unsigned int> firsts_; /// for each chunk, all its indices are >= its first and < the first of the next one
+    std::size_t size_;
+};
+
+
 class orderStorage
 {
 public:
     friend pure_LELiteral_iterator;
     using vector = LitVec;
-    using map = std::map<unsigned int, Literal>;
+    using map = SparseLitMap;
 private:
     enum store : unsigned int {hasvector=1, hasmap=2};
     unsigned int store_;
     /// \brief vector
     /// we may have a vector and/or a map (non-exclusive or but at least one)
+    /// the map is replaced by the vector as soon as the vector needs less memory
     ///
     vector vector_;
-    //std::unique_ptr<std::unordered_map<unsigned int,Literal>> hashMap;
     map map_;
     unsigned int maxSize_;
 public:
+    /// lazy variables with smaller domains also keep the vector from the start
+    static const unsigned int denseSize = 1000000;
+
     orderStorage() : store_(0), maxSize_(0) {}
 
     void useVector() { store_ = store_ | hasvector; }
@@ -130,31 +246,41 @@ public:
             vector_[index]=l;
         }
 
-        /// if map is a third of the vector, remove it
-        if ((store_ == (hasvector & hasmap)) && map_.size()*3>=maxSize_)
-        {
-            map_.clear();
-            store_ = hasvector;
-        }
-
         if (store_ & hasmap)
         {
             //std::cout << "create lit in hasmap " << l.var() << std::endl;
             map_.emplace(index,l);
         }
 
-        if (store_ == hasmap && map_.size()*3>=maxSize_) /// convert map to vector if it gets too large
+        /// the map is dense enough that the vector needs less memory
+        if (store_ & hasmap && map_.size()*sizeof(map::value_type)>=std::size_t(maxSize_)*sizeof(Literal))
         {
-            store_ = hasvector;
-            Literal l(0,false);
-            l.flag();
-            vector_.resize(maxSize_, l);
-            while(!map_.empty())
+            if (!hasVector())
             {
-                vector_[map_.begin()->first] = map_.begin()->second;
-                map_.erase(map_.begin());
+                Literal l(0,false);
+                l.flag();
+                vector_.resize(maxSize_, l);
+                for (const auto& i : map_)
+                    vector_[i.first] = i.second;
             }
+            map_.clear();
+            store_ = hasvector;
+        }
+    }
+
+    /// calls f(index, literal) for every created literal in ascending order of the index
+    template<class F>
+    void forEach(F f) const
+    {
+        if (store_ & hasvector)
+        {
+            for (unsigned int i = 0; i != vector_.size(); ++i)
+                if (!vector_[i].flagged())
+                    f(i, vector_[i]);
         }
+        else
+            for (const auto& i : map_)
+                f(i.first, i.second);
     }
 
     Literal getLiteral(unsigned int index) const
@@ -385,7 +511,7 @@ public:
     friend VariableStorage;
     friend VolatileVariableStorage;
 
-    VariableCreator(CreatingSolver& s, Config conf) : s_(s), conf_(conf) {}
+    VariableCreator(CreatingSolver& s, Config conf) : s_(s), numEqualLits_(0), conf_(conf) {}
     std::size_t numVariables() const { return domains_.size(); }
 
     ViewDomain getViewDomain(const View& v) const
@@ -433,9 +559,9 @@ public:
 
     bool isValid(const Variable& v) const { return (v < domains_.size() && domains_[v]!=nullptr); }
 
-    Variable createVariable(const Domain& d = Domain())
+    Variable createVariable(Domain d = Domain())
     {
-        domains_.emplace_back(new Domain(d));
+        domains_.emplace_back(new Domain(std::move(d)));
         Variable v = domains_.size()-1;
         return v;
     }
@@ -642,7 +768,7 @@ public:
         return getEqualLit(it);
     }
 
-    unsigned int numEqualLits() const { return equalLits_.size(); }
+    unsigned int numEqualLits() const { return numEqualLits_; }
 
     /// stores unary eq/ne constraints as literals for reuse
     /// if the literal already exists, posts boolean equality of the two
@@ -652,7 +778,7 @@ public:
 
     bool createOrderLiterals(const Variable& i);
 
-    /// could in theory also work incrementally ?
+    /// creates the clauses for all equality literals added since the last call
     bool createEqualClauses();
 
     void prepareOrderLitMemory();
@@ -683,6 +809,9 @@ private:
     /// pre: hasEqualLit(it).first = false
     Literal createEqualLit(Restrictor::ViewIterator it);
 
+    /// stores (v=i) == l, pre: there is no literal for (v=i) yet
+    void addEqualLit(Variable v, int32 i, Literal l);
+
     bool hasOrderLitMemory(const Variable& var) const
     {
         if (!isValid(var)) return false;
@@ -712,11 +841,13 @@ private:
     std::vector<std::unique_ptr<Domain> > domains_;
 
     mutable std::vector<orderStorage> orderLitMemory_; /// these unique pointers just manage the memory of the order literals
-                                                       /// on very large domains > 1.000.000 and lazy_literals true we use a map instead
-    std::map<std::pair<Variable,int>,Literal> equalLits_; // given a variable and a number, may contain a literal
-                                                          // (var = int) == lit
-                                                          // if the literal is not flagged, we still need to introduce equality constraints
-                                                          // TODO: if equality lits are created on the fly, flag them ?
+                                                       /// with lazy literals we use a sparse map until the vector gets smaller
+    std::vector<std::unordered_map<int32,Literal> > equalLits_; // for each variable, given a number, may contain a literal
+                                                               // (var = int) == lit
+                                                               // if the literal is not flagged, we still need to introduce equality constraints
+    std::vector<std::pair<Variable,int32> > newEqualLits_; /// equality literals without equality clauses
+    std::vector<std::pair<Variable,int32> > undecidedEqualLits_; /// equality literals not yet used to restrict the domains
+    unsigned int numEqualLits_;
     Config conf_;
 
 };
@@ -745,7 +876,7 @@ public:
 
     friend std::ostream& operator<< (std::ostream& stream, const VariableStorage& s);
 
-    void addLevel() { levelSets_.push_back(VarSet()); }
+    void addLevel() { levels_.emplace_back(trail_.size()); }
     void removeLevel();
 
     /// return false if the domain is empty
@@ -759,11 +890,11 @@ public:
         if (toVar.numElement()==domains_[v]->size()) // end iterator, should not change anything
             return true;
 
-        if (toVar < rs_[v].back().begin())
-            constrainVariable(Restrictor(rs_[v].back().begin(),rs_[v].back().begin()));
+        if (toVar < rs_[v].begin())
+            constrainVariable(Restrictor(rs_[v].begin(),rs_[v].begin()));
         else
-            constrainVariable(Restrictor(rs_[v].back().begin(),toVar));
-        return rs_[v].back().size()>0;
+            constrainVariable(Restrictor(rs_[v].begin(),toVar));
+        return rs_[v].size()>0;
     }
 
     /// return false if the domain is empty
@@ -773,26 +904,38 @@ public:
         if(l.view().reversed())
             return constrainUpperBound(toVar);
 
-        if (toVar > rs_[v].back().end())
-            constrainVariable(Restrictor(rs_[v].back().end(),rs_[v].back().end()));
+        if (toVar > rs_[v].end())
+            constrainVariable(Restrictor(rs_[v].end(),rs_[v].end()));
         else
-            constrainVariable(Restrictor(toVar,rs_[v].back().end()));
-        return rs_[v].back().size()>0;
+            constrainVariable(Restrictor(toVar,rs_[v].end()));
+        return rs_[v].size()>0;
     }
 
+    /// the domains have been restricted in place (e.g. by the VariableCreator),
+    /// which invalidates the restrictors pointing into them,
+    /// sets the restrictor of each valid variable v to its new domain restricted to bounds[v]
+    /// the trail is dropped, so the base level can not be restored afterwards
+    /// pre: only the base level exists
+    /// return false if a domain is empty
+    bool rebase(const std::vector<std::pair<int64,int64> >& bounds);
+
+
+    /// adds the variables that have been created since construction
+    /// pre: only the base level exists and the domains of the old variables did not change
+    void extend();
 
     /// returns a restrictor for inspection, to change it, call constrainVariable
     Restrictor getCurrentRestrictor(const View& v) const
     {
         assert(isValid(v.v));
-        return Restrictor(v,rs_[v.v].back());
+        return Restrictor(v,rs_[v.v]);
     }
 
     /// returns a restrictor for inspection, to change it, call constrainVariable
     const Restrictor& getCurrentRestrictor(const Variable& v) const
     {
         assert(isValid(v));
-        return rs_[v].back();
+        return rs_[v];
     }
 
     /// returns a restrictor for inspection, to change it, call constrainVariable
@@ -887,11 +1030,20 @@ private:
 
 
     Literal trueLit_;
-    using ResVec = std::vector<Restrictor>;
-    std::vector<ResVec> rs_; /// for each variable, there is a stack of restrictors (added whenever there was a change)
-                             /// the restrictors need to have a simple view, ie a = 1, c = 0
-    using VarSet = std::set<Variable>;
-    std::vector<VarSet> levelSets_; /// for each level we have a set of stored variables, TODO: bad data structure ?
+    std::vector<Restrictor> rs_; /// for each variable, the restrictor of the current level
+                                 /// the restrictors need to have a simple view, ie a = 1, c = 0
+
+    /// a restrictor that was overwritten, together with the level the variable was stored on before
+    struct TrailEntry
+    {
+        TrailEntry(Variable v, uint32 level, const Restrictor& r) : v(v), level(level), r(r) {}
+        Variable v;
+        uint32 level;
+        Restrictor r;
+    };
+    std::vector<TrailEntry> trail_; /// undo trail, each variable is stored at most once per level
+    std::vector<std::size_t> levels_; /// for each level, the size of the trail when the level was added
+    std::vector<uint32> stamps_; /// for each variable, the level on which it was last stored on the trail
     //const VariableCreator& vc_;
     const std::vector<std::unique_ptr<Domain> >& domains_; // this is just a reference to the global domains
     const std::vector<orderStorage>& orderLitMemory_;
@@ -919,12 +1071,152 @@ public:
 
     const orderStorage& getStorage(Variable v) const {return volOrderLitMemory_[v]; }
 
+    /// takes over the order literals of vc, which drops the literals created locally,
+    /// and adds the variables that have been created since construction
+    /// pre: see VariableStorage::extend
+    void extend(const VariableCreator& vc)
+    {
+        volOrderLitMemory_ = vc.orderLitMemory_;
+        vs_.extend();
+    }
+
 private:
       std::vector<orderStorage> volOrderLitMemory_;
       //std::map<std::pair<Variable,int>,Literal> volEqualLit_;
       VariableStorage vs_;
 };
 
+/// remembers which order literals var<=domain[index] have been created lazily
+/// by the solver threads during one solve step, together with the number of threads
+/// that created the same literal
+/// with a pool of free literals of the master, the threads also take the lazily created literals
+/// from the pool, so that all threads share one literal per bound during the solve step
+/// marking and sharing are lock free and can be done concurrently from all threads,
+/// all other functions must not be called while solving
+class LazyLiteralRegistry
+{
+public:
+    LazyLiteralRegistry() : numVars_(0), nextPool_(0) {}
+    LazyLiteralRegistry(const LazyLiteralRegistry&) = delete;
+    LazyLiteralRegistry& operator=(const LazyLiteralRegistry&) = delete;
+    ~LazyLiteralRegistry() { reset(0); }
+
+    /// forgets all marks and the pool and prepares the registry for numVars variables
+    void reset(std::size_t numVars);
+
+    /// the literals that can be shared in this solve step, they must not be used by any constraint
+    /// pre: reset has been called for this step
+    void setPool(const std::vector<Literal>& pool);
+    std::size_t poolSize() const { return pool_.size(); }
+    Literal poolLiteral(std::size_t i) const { return pool_[i]; }
+
+    /// sets l to the shared literal of var<=domain[index], the first thread asking for it takes one from the pool
+    /// returns false if the pool is exhausted
+    /// thread safe
+    bool share(Variable var, unsigned int index, Literal& l);
+
+    /// returns true if the pool literal i stands for var<=domain[index] and sets var and index,
+    /// returns false if it stands for nothing and has to be false,
+    /// pool literals that have not been taken yet can no longer be taken afterwards
+    /// thread safe
+    bool poolBound(std::size_t i, Variable& var, unsigned int& index);
+
+    std::size_t numVariables() const { return numVars_; }
+
+    /// one thread created the literal var<=domain[index]
+    /// returns the number of threads that created this literal so far
+    /// thread safe
+    unsigned int mark(Variable var, unsigned int index);
+
+    /// returns the number of threads that created the literal var<=domain[index]
+    unsigned int count(Variable var, unsigned int index) const;
+
+    /// calls f(index, count) for every literal of var that has been created at least once
+    template<class F>
+    void forEach(Variable var, F f) const
+    {
+        assert(var < numVars_);
+        for (const Block* b = heads_[var].load(std::memory_order_acquire); b != nullptr; b = b->next)
+            for (unsigned int i = 0; i != blockSize; ++i)
+            {
+                unsigned int c = b->count[i].load(std::memory_order_relaxed);
+                if (c)
+                    f(b->base+i, c);
+            }
+    }
+
+private:
+    static const unsigned int blockSize = 64;
+    /// counters and shared literals for the indices [base,base+blockSize) of one variable
+    struct Block
+    {
+        Block(unsigned int base) : base(base), next(nullptr)
+        {
+            for (auto& i : count)
+                i.store(0, std::memory_order_relaxed);
+            for (auto& i : shared)
+                i.store(0, std::memory_order_relaxed);
+        }
+        unsigned int base;
+        std::atomic<unsigned int> count[blockSize];
+        std::atomic<uint64> shared[blockSize]; /// index+1 of the pool literal, 0 if there is none
+        Block* next;
+    };
+    /// the block of var that contains index, creates it if there is none
+    Block& block(Variable var, unsigned int index);
+
+    enum : uint64 { closed = std::numeric_limits<uint64>::max() };
+    /// per variable a list of blocks, new blocks are only prepended
+    std::unique_ptr<std::atomic<Block*>[]> heads_;
+    std::size_t numVars_;
+    std::vector<Literal> pool_;
+    /// for every pool literal, (var<<32 | index)+1 of its bound, 0 if it has not been taken yet, closed if it stands for nothing
+    std::unique_ptr<std::atomic<uint64>[]> owners_;
+    std::atomic<std::size_t> nextPool_; /// the next pool literal to take
+};
+
+
+/// counts how often each lazily propagated linear constraint produced nogoods
+/// in the solver threads during one solve step
+/// marking is lock free and can be done concurrently from all threads,
+/// all other functions must not be called while solving
+class ConstraintActivity
+{
+public:
+    ConstraintActivity() : size_(0) {}
+    ConstraintActivity(const ConstraintActivity&) = delete;
+    ConstraintActivity& operator=(const ConstraintActivity&) = delete;
+
+    /// forgets all counts and prepares the registry for numConstraints constraints
+    void reset(std::size_t numConstraints)
+    {
+        size_ = numConstraints;
+        count_.reset(size_ ? new std::atomic<unsigned int>[size_] : nullptr);
+        for (std::size_t i = 0; i != size_; ++i)
+            count_[i].store(0, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return size_; }
+
+    /// constraint id produced nogoods in one propagation step
+    /// thread safe
+    void mark(std::size_t id)
+    {
+        assert(id < size_);
+        count_[id].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    unsigned int count(std::size_t id) const
+    {
+        assert(id < size_);
+        return count_[id].load(std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<std::atomic<unsigned int>[]> count_;
+    std::size_t size_;
+};
+
 
 inline std::ostream& operator<< (std::ostream& stream, const VariableStorage& s)
 {
@@ -933,8 +1225,7 @@ inline std::ostream& operator<< (std::ostream& stream, const VariableStorage& s)
         if (s.isValid(i))
         {
             stream << "Var " << i << ":\t";
-            for (auto r = s.rs_[i].begin(); r != s.rs_[i].end(); ++r)
-                stream << *r;
+            stream << s.rs_[i];
             stream << std::endl;
         }
     }
@@ -33,16 +33,38 @@
 namespace order
 {
 
+/// the nogoods of a translated implication v -> l before their order literals are created,
+/// each nogood is the clause ~v or ~GE(it) for all iterators it of the nogood
+struct TranslatedClauses
+{
+    TranslatedClauses() : v(0,false) {}
+    Literal v;
+    std::vector<Restrictor::ViewIterator> its; /// the iterators of all nogoods
+    std::vector<std::size_t> ends; /// for each nogood, the end of its iterators in its
+};
+
 class Translator
 {
 public:
-    Translator(CreatingSolver& s, const Config& conf) : s_(s), conf_(conf)
+    Translator(CreatingSolver& s, const Config& conf) : s_(s), conf_(conf), clauses_(s)
     {}
 
-    /// translate the constraint
+    /// translate the constraint, the clauses are buffered until flush is called
     /// returns false if addclause fails
     bool doTranslate(VariableCreator &vc, const ReifiedLinearConstraint& l);
 
+    /// enumerate the nogoods of the constraint into out without creating order literals or clauses,
+    /// can be called concurrently as long as the domains of vc do not change
+    void doTranslate(const VariableCreator &vc, const ReifiedLinearConstraint& l, TranslatedClauses& out) const;
+
+    /// create the order literals and clauses of the enumerated nogoods in their order,
+    /// the clauses are buffered until flush is called
+    /// returns false if addclause fails
+    bool commit(VariableCreator &vc, const TranslatedClauses& c);
+
+    /// create all buffered clauses
+    /// returns false if addclause fails
+    bool flush() { return clauses_.flush(); }
 
 private:
 
@@ -50,31 +72,14 @@ private:
     bool doTranslateImplication(VariableCreator &vc, Literal l, const LinearConstraint& c);
     CreatingSolver& s_;
     const Config& conf_;
+    ClauseBuffer clauses_;
 };
 
-inline bool translate(CreatingSolver& s, VariableCreator& vc, std::vector<ReifiedLinearConstraint>& rl, const Config& conf)
-{
-    Translator t(s, conf);
-
-    uint64 size = conf.translateConstraints == -1 ? std::numeric_limits<uint64>::max() : conf.translateConstraints;
-
-
-    unsigned int num = rl.size();
-    for (unsigned int i = 0; i < num;)
-    {
-        if (rl[i].l.productOfDomainsExceptLastLEx(vc,size))
-        {
-            if (!t.doTranslate(vc,rl[i]))
-                return false;
-            std::swap(rl[i],*(rl.begin()+num-1));
-            --num;
-        }
-        else
-            ++i;
-    }
-    rl.erase(rl.begin()+num,rl.end());
-    return true;
-}
+/// translates the constraints of rl that produce at most conf.translateConstraints nogoods
+/// and removes them from rl
+/// with conf.translateThreads > 1, the nogoods are enumerated concurrently
+/// and the clauses are created afterwards in the order of the constraints
+bool translate(CreatingSolver& s, VariableCreator& vc, std::vector<ReifiedLinearConstraint>& rl, const Config& conf);
 
 
 }
@@ -43,7 +43,8 @@ Domain LinearConstraint::lhsDomain(const CreatingSolver& s, const VariableCreato
     /// as we are ok with an overapproximation
     /// and getDomain(view) gives accurate domain which can be expensive
     //Domain newDom(vc.getDomain(*views_.begin()));
-    Domain newDom(Domain(vc.getDomain(views_.begin()->v)).times(views_.begin()->a, conf.domSize));
+    Domain newDom(vc.getDomain(views_.begin()->v));
+    newDom.inplace_times(views_.begin()->a, conf.domSize);
     if (newDom.overflow())
     {
         s.intermediateVariableOutOfRange();
@@ -51,7 +52,9 @@ Domain LinearConstraint::lhsDomain(const CreatingSolver& s, const VariableCreato
     }
     for(auto j = views_.begin()+1; j != views_.end(); ++j)
     {
-        newDom+= Domain(vc.getDomain(j->v)).times(j->a, conf.domSize);
+        Domain d(vc.getDomain(j->v));
+        d.inplace_times(j->a, conf.domSize);
+        newDom+= d;
         if (newDom.overflow())
         {
             s.intermediateVariableOutOfRange();
@@ -18,13 +18,13 @@
 
 // }}}
 
-/*#include <order/dlpropagator.h>
+#include <order/dlpropagator.h>
 
 #include <set>
+#include <map>
 #include <unordered_set>
-#include <iostream>
-#include <queue>
-#include <limits>
+#include <algorithm>
+#include <cstdlib>
 
 
 namespace difflogic
@@ -50,7 +50,6 @@ public:
     {
         assert(vec.size());
         return vec[0];
-        assert(debug_integrity());
     }
 
     void popSmallest()
@@ -63,21 +62,12 @@ public:
     }
 
 
-//    void popSmallest()
-//    {
-//        assert(vec.size());
-    //DOES NOT WORK
-//        vec[0] = std::numeric_limits<unsigned int>::max();
-//        moveDown(0);
-//        vec.pop_back();
-//    }
-
     void moveDown(unsigned int heapIndex)
     {
         while(true)
         {
-            int leftChild = 2*heapIndex + 1;
-            int rightChild = 2*heapIndex + 2;
+            unsigned int leftChild = 2*heapIndex + 1;
+            unsigned int rightChild = 2*heapIndex + 2;
 
             if (leftChild>=vec.size())
                 return;
@@ -169,7 +159,6 @@ public:
     {
         assert(vec.size());
         return vec[0];
-        assert(debug_integrity());
     }
     void popSmallest()
     {
@@ -187,12 +176,8 @@ public:
     {
         if (outgoing_[index].heapIndex==std::numeric_limits<unsigned int>::max())
             return -1;
-        else
-        {
-            assert(outgoing_[index].heapIndex<vec.size() && vec[outgoing_[index].heapIndex]==index);
-            return outgoing_[index].heapIndex;
-        }
-        assert(debug_integrity());
+        assert(outgoing_[index].heapIndex<vec.size() && vec[outgoing_[index].heapIndex]==index);
+        return outgoing_[index].heapIndex;
     }
 
 
@@ -200,8 +185,8 @@ public:
     {
         while(true)
         {
-            int leftChild = 2*heapIndex + 1;
-            int rightChild = 2*heapIndex + 2;
+            unsigned int leftChild = 2*heapIndex + 1;
+            unsigned int rightChild = 2*heapIndex + 2;
 
             if (leftChild>=vec.size())
                 return;
@@ -276,17 +261,19 @@ public:
 
 DLPropagator::EdgeId DLPropagator::addEdge(Variable a, Weight weight, Variable b)
 {
-    potential_.resize(std::max((unsigned int)(potential_.size()), std::max(a+1,b+1)));
+    potential_.resize(std::max((Variable)(potential_.size()), std::max(a+1,b+1)));
     outgoing_.resize(std::max(b+1, std::max((Variable)(outgoing_.size()), a+1)));
     edges_.emplace_back(a,weight,b);
-    outgoing_[a].out.emplace_back(b, weight,edges_.size());
-    outgoing_[b].out.emplace_back(a, -weight-1, -edges_.size());
+    EdgeId id = edges_.size();
+    outgoing_[a].out.emplace_back(b, weight, id);
+    outgoing_[b].out.emplace_back(a, -weight-1, -id);
     truthTable_.resize(edges_.size()+1,0);
-    return edges_.size();
+    return id;
 }
 
 std::vector<DLPropagator::EdgeId> DLPropagator::activate(EdgeId id)
 {
+    assert(id>0 && !isFalse(id));
     if (isTrue(id))
         return std::vector<DLPropagator::EdgeId>();
     activityQueue_.emplace_back(id);
@@ -305,11 +292,7 @@ std::vector<DLPropagator::EdgeId> DLPropagator::activate(EdgeId id)
 void DLPropagator::nonrec_activate(EdgeId id)
 {
     assert(isUnknown(id));
-
-    if (id>0)
-        truthTable_[id] = currentLevel_;
-    else
-        truthTable_[-id] = -(int32)(currentLevel_);
+    truthTable_[id] = currentLevel_;
 
     Edge e = getEdge(id);
     unsigned int a = e.in;
@@ -342,7 +325,7 @@ void DLPropagator::nonrec_activate(EdgeId id)
             {
                 if (isTrue(i.id))
                 {
-                    int newChange = potential_[var] + int64(i.weight) - potential_[i.vertex];
+                    int64 newChange = potential_[var] + int64(i.weight) - potential_[i.vertex];
                     if (newChange<0)
                     {
                     //changes.emplace(-newChange, std::make_pair(i.vertex,-(-int(potential_[var]) + i.weight)));
@@ -376,26 +359,22 @@ void DLPropagator::nonrec_activate(EdgeId id)
     }
 }
 
-unsigned int DLPropagator::level(EdgeId id)
+unsigned int DLPropagator::level(EdgeId id) const
 {
-    assert(!isUnknown(id));
-    return std::abs(truthTable_[abs(id)]);
-}
-
-std::vector<DLPropagator::EdgeId> DLPropagator::deactivate(EdgeId id)
-{
-    return activate(-id);
+    assert(truthTable_[std::abs(id)]!=0);
+    return std::abs(truthTable_[std::abs(id)]);
 }
 
 
  std::vector<DLPropagator::EdgeId> DLPropagator::reason(EdgeId id)
  {
+     assert(id<0 && isFalse(-id));
      std::vector<EdgeId> ret;
      std::vector<Variable> seen;
      auto mycomp = [this](const uint64&a, const uint64& b) { return outgoing_[a].data1 < outgoing_[b].data1; };
      ExtendedMinBinaryHeap<decltype(mycomp)> heap(mycomp, outgoing_);
      /// compute shortest path from a to b with only using true edges c
-     /// level(c) < level(e)
+     /// level(c) < level(e), where a->b is the opposite of the false edge
      unsigned int l = level(id);
      Edge e = getEdge(id);
 
@@ -429,7 +408,7 @@ std::vector<DLPropagator::EdgeId> DLPropagator::deactivate(EdgeId id)
              const auto& out = outgoing_[x].out[i];
              if (isTrue(out.id) && level(out.id) < l)
              {
-                 uint64 newWeight = outgoing_[x].data1+weight(x,out.weight,out.vertex);
+                 int64 newWeight = outgoing_[x].data1+weight(x,out.weight,out.vertex);
                  int heapIndex = heap.isInside(out.vertex);
                  if (heapIndex < 0) /// not in heap
                  {
@@ -480,7 +459,8 @@ void DLPropagator::undo()
 {
     assert(activityQueue_.back()==0);
     activityQueue_.pop_back();
-    while(activityQueue_.back()!=0)
+    /// the oldest activation has no separator in front of it
+    while(!activityQueue_.empty() && activityQueue_.back()!=0)
     {
         undo(activityQueue_.back());
         activityQueue_.pop_back();
@@ -491,12 +471,15 @@ void DLPropagator::undo()
 
 void DLPropagator::undo(EdgeId id)
 {
+    assert(truthTable_[std::abs(id)]!=0);
+    truthTable_[std::abs(id)]=0;
+    /// false edges never changed the potential
+    if (id<0)
+        return;
+
     Edge e = getEdge(id);
     const Variable& b = e.out;
 
-    assert(!isUnknown(id));
-    truthTable_[abs(id)]=0;
-
     //auto mycomp = [](const uint64&a, const uint64& b) { return a > b; };
     //std::multimap<uint64,std::pair<Variable,uint64>, decltype(mycomp)> changes(mycomp); /// positive potential change -> (var/negative final potential)
     auto mycomp = [this](const uint64&a, const uint64& b) { return outgoing_[a].data1 < outgoing_[b].data1; };
@@ -557,30 +540,6 @@ void DLPropagator::undo(EdgeId id)
 }
 
 
-bool DLPropagator::isTrue(EdgeId id) const
-{
-    return (truthTable_[abs(id)] > 0 && id > 0) || (truthTable_[abs(id)] < 0 && id < 0);
-//    if (e.weight>=0)
-//        return truthTable_.find(e) != truthTable_.end() &&  (truthTable_.find(e)->second > 0);
-//    else
-//        return isFalse(InternalEdge(e.out, -e.weight-1, e.in));
-}
-
-bool DLPropagator::isFalse(EdgeId id) const
-{
-    return (truthTable_[abs(id)] < 0 && id > 0) || (truthTable_[abs(id)] > 0 && id < 0);
-//    if (e.weight>=0)
-//        return truthTable_.find(e) != truthTable_.end() && (truthTable_.find(e)->second < 0);
-//    else
-//        return isTrue(InternalEdge(e.out, -e.weight-1, e.in));
-}
-
-bool DLPropagator::isUnknown(EdgeId id) const
-{
-    return truthTable_[abs(id)]==0;
-}
-
-
 std::vector<DLPropagator::EdgeId> DLPropagator::propagate(EdgeId id)
 {
     ///TODO: think about a rewrite using the new EdgeId thingy
@@ -856,7 +815,7 @@ std::vector<DLPropagator::EdgeId> DLPropagator::propagate(EdgeId id)
                     if (negRelevancy.find(out.vertex)!=negRelevancy.end() && outgoing_[i].data1 + outgoing_[out.vertex].data2 - w + out.weight < 0 )
                     {
                         //FOUND
-                        nonrec_activate(-out.id);
+                        truthTable_[out.id] = -(int32)(currentLevel_);
                         ret.emplace_back(-out.id);
                     }
                 }
@@ -872,10 +831,10 @@ std::vector<DLPropagator::EdgeId> DLPropagator::propagate(EdgeId id)
                 if (isUnknown(-out.id))
                 {
                     //std::cout << negDistance[i].second << " + " << posDistance[out.vertex].second << " - " << w << " + " << -out.weight-1 << " < " <<  0 << std::endl;
-                    if (posRelevancy.find(out.vertex)!=negRelevancy.end() && (int64)(outgoing_[i].data2 + outgoing_[out.vertex].data1 - w + (-out.weight-1) < 0 ))
+                    if (posRelevancy.find(out.vertex)!=posRelevancy.end() && outgoing_[i].data2 + outgoing_[out.vertex].data1 - w + (-out.weight-1) < 0)
                     {
                         //FOUND
-                        nonrec_activate(out.id);
+                        truthTable_[-out.id] = -(int32)(currentLevel_);
                         ret.emplace_back(out.id);
                     }
                 }
@@ -893,7 +852,7 @@ bool DLPropagator::hasNegativeCycle() const
         return false;
 
     std::set<Variable> variables;
-    for (unsigned int index_e = 0; index_e != edges_.size(); ++index_e)
+    for (EdgeId index_e = 1; index_e <= (EdgeId)(edges_.size()); ++index_e)
     {
         if (isTrue(index_e))
         {
@@ -903,6 +862,9 @@ bool DLPropagator::hasNegativeCycle() const
         }
     }
 
+    if (variables.empty())
+        return false;
+
     std::map<Variable,int64> distance;
     Variable start = *variables.begin();
     bool cont = false;
@@ -911,7 +873,7 @@ bool DLPropagator::hasNegativeCycle() const
         distance[start] = 0;
         for (unsigned int count = 0; count < outgoing_.size()-1; ++count)
         {
-            for (unsigned int index_e = 0; index_e != edges_.size(); ++index_e)
+            for (EdgeId index_e = 1; index_e <= (EdgeId)(edges_.size()); ++index_e)
             {
                 if (isTrue(index_e))
                 {
@@ -946,7 +908,7 @@ bool DLPropagator::hasNegativeCycle() const
 
 
     /// check
-    for (unsigned int index_e = 0; index_e != edges_.size(); ++index_e)
+    for (EdgeId index_e = 1; index_e <= (EdgeId)(edges_.size()); ++index_e)
     {
         if (isTrue(index_e))
         {
@@ -976,5 +938,3 @@ bool DLPropagator::hasNegativeCycle() const
 
 }
 
-*/
-
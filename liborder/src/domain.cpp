@@ -23,6 +23,248 @@
 
 namespace order
 {
+
+namespace
+{
+
+int64 gcd(int64 a, int64 b)
+{
+    while (b != 0)
+    {
+        int64 t = a%b;
+        a = b;
+        b = t;
+    }
+    return a < 0 ? -a : a;
+}
+
+/// a mod m in [0,m)
+/// pre: m > 0
+int64 posmod(int64 a, int64 m)
+{
+    int64 r = a%m;
+    return r < 0 ? r+m : r;
+}
+
+/// returns x such that a*x = 1 mod m
+/// pre: gcd(a,m)==1, m > 0
+int64 inverse(int64 a, int64 m)
+{
+    int64 t = 0, newt = 1;
+    int64 r = m, newr = posmod(a,m);
+    while (newr != 0)
+    {
+        int64 q = r/newr;
+        t -= q*newt;
+        std::swap(t,newt);
+        r -= q*newr;
+        std::swap(r,newr);
+    }
+    return posmod(t,m);
+}
+
+/// the smallest element of the progression l,l+s,... that is >= x
+/// pre: x >= l
+int64 firstFrom(int64 l, int64 s, int64 x) { return l + (x-l+s-1)/s*s; }
+
+/// the biggest element of the progression l,l+s,... that is <= x
+/// pre: x >= l
+int64 lastUntil(int64 l, int64 s, int64 x) { return l + (x-l)/s*s; }
+
+template<class R>
+void fixStride(R& r)
+{
+    if (r.l==r.u)
+        r.s=1;
+}
+
+/// intersects the progressions al,al+as,..,au and bl,bl+bs,..,bu
+/// returns false if the intersection is empty, otherwise sets its first, last element and stride
+bool intersectProgressions(int64 al, int64 au, int64 as, int64 bl, int64 bu, int64 bs, int64& first, int64& last, int64& stride)
+{
+    int64 lo = std::max(al,bl);
+    int64 hi = std::min(au,bu);
+    if (lo>hi)
+        return false;
+    if (as==1 && bs==1)
+    {
+        first = lo;
+        last = hi;
+        stride = 1;
+        return true;
+    }
+    /// chinese remainder, x = al mod as and x = bl mod bs
+    int64 g = gcd(as,bs);
+    if ((bl-al)%g != 0)
+        return false;
+    int64 m = bs/g;
+    int64 k = posmod(posmod((bl-al)/g,m) * inverse(as/g,m), m);
+    stride = as/g*bs;
+    first = lo + posmod(al + as*k - lo, stride);
+    if (first > hi)
+        return false;
+    last = lastUntil(first, stride, hi);
+    if (first==last)
+        stride = 1;
+    return true;
+}
+
+/// add the elements of p between a and b to out
+template<class R>
+void addPiece(const R& p, decltype(R::l) a, decltype(R::l) b, std::vector<R>& out)
+{
+    if (a>b)
+        return;
+    R piece(firstFrom(p.l,p.s,a), lastUntil(p.l,p.s,b), p.s);
+    if (piece.l>piece.u)
+        return;
+    fixStride(piece);
+    out.emplace_back(piece);
+}
+
+/// unify r with the ranges [first,last), which all overlap or touch r
+/// appends the resulting ranges to out in ascending order
+template<class R, class It>
+void unite(It first, It last, const R& r, std::vector<R>& out)
+{
+    using T = decltype(R::l);
+    std::vector<R> intervals;
+    std::vector<R> progressions;
+    bool inserted = false;
+    for (auto i = first; i != last; ++i)
+    {
+        if (!inserted && r.l < i->l)
+        {
+            (r.s==1 ? intervals : progressions).emplace_back(r);
+            inserted = true;
+        }
+        (i->s==1 ? intervals : progressions).emplace_back(*i);
+    }
+    if (!inserted)
+        (r.s==1 ? intervals : progressions).emplace_back(r);
+
+    /// contiguous parts are merged directly
+    std::vector<R> merged;
+    for (const auto& i : intervals)
+    {
+        if (!merged.empty() && i.l <= merged.back().u+1)
+            merged.back().u = std::max(merged.back().u, i.u);
+        else
+            merged.emplace_back(i);
+    }
+
+    /// remove the parts of the progressions that are already covered
+    std::vector<R> pieces;
+    for (const auto& p : progressions)
+    {
+        T from = p.l;
+        for (const auto& i : merged)
+        {
+            if (i.u < from)
+                continue;
+            if (i.l > p.u)
+                break;
+            addPiece(p, from, i.l-1, pieces);
+            from = i.u+1;
+        }
+        addPiece(p, from, p.u, pieces);
+    }
+    std::sort(pieces.begin(), pieces.end(), [](const R& a, const R& b){ return a.l < b.l; });
+
+    /// overlapping progressions are joined if they share stride and offset,
+    /// otherwise their elements are enumerated
+    std::vector<R> resolved;
+    for (std::size_t i = 0; i < pieces.size();)
+    {
+        std::size_t j = i+1;
+        T hi = pieces[i].u;
+        T stride = pieces[i].s;
+        while (j < pieces.size() && pieces[j].l <= hi)
+        {
+            hi = std::max(hi, pieces[j].u);
+            stride = std::max(stride, pieces[j].s);
+            ++j;
+        }
+        bool same = true;
+        for (std::size_t k = i; k < j && same; ++k)
+            same = (pieces[k].s==stride || pieces[k].l==pieces[k].u) && (pieces[k].l-pieces[i].l)%stride==0;
+        if (same)
+        {
+            R joined(pieces[i].l, hi, stride);
+            fixStride(joined);
+            resolved.emplace_back(joined);
+        }
+        else
+        {
+            std::vector<T> elements;
+            for (std::size_t k = i; k < j; ++k)
+                for (uint64 n = 0; n < (uint64)(pieces[k].size()); ++n)
+                    elements.emplace_back(pieces[k].l + (T)(n)*pieces[k].s);
+            std::sort(elements.begin(), elements.end());
+            elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+            /// greedily compress the elements into progressions
+            for (std::size_t k = 0; k < elements.size();)
+            {
+                std::size_t l = k+1;
+                if (l < elements.size())
+                {
+                    T step = elements[l]-elements[k];
+                    while (l+1 < elements.size() && elements[l+1]-elements[l]==step)
+                        ++l;
+                    resolved.emplace_back(elements[k], elements[l], step);
+                    k = l+1;
+                }
+                else
+                {
+                    resolved.emplace_back(elements[k], elements[k]);
+                    k = l;
+                }
+            }
+        }
+        i = j;
+    }
+
+    std::vector<R> all;
+    std::merge(merged.begin(), merged.end(), resolved.begin(), resolved.end(), std::back_inserter(all), [](const R& a, const R& b){ return a.l < b.l; });
+    for (const auto& i : all)
+    {
+        if (!out.empty() && out.back().s==1 && i.s==1 && out.back().u+1==i.l)
+            out.back().u = i.u;
+        else
+            out.emplace_back(i);
+    }
+}
+
+/// unify ranges with r, start is a hint where r can be inserted
+/// return iterator to a range where a bigger range can be inserted next time
+template<class C>
+typename C::iterator addRange(C& ranges, typename C::iterator start, const typename C::value_type& r)
+{
+    using R = typename C::value_type;
+    /// all ranges that overlap or touch r
+    auto first = std::lower_bound(start, ranges.end(), r, [](const R& x, const R& y){ return x.u+1 < y.l; });
+    auto last = first;
+    bool contiguous = r.s==1;
+    while (last != ranges.end() && last->l <= r.u+1)
+    {
+        contiguous = contiguous && last->s==1;
+        ++last;
+    }
+    if (first==last)
+        return ranges.insert(first,r);
+    if (contiguous)
+    {
+        first->l = std::min(first->l,r.l);
+        first->u = std::max((last-1)->u,r.u);
+        return ranges.erase(first+1,last)-1;
+    }
+    std::vector<R> united;
+    unite(first,last,r,united);
+    auto pos = ranges.erase(first,last);
+    return ranges.insert(pos,united.begin(),united.end());
+}
+
+}
 /*
 Domain::Domain(const Restrictor& r) : overflow_(false)
 {
@@ -41,7 +283,16 @@ bool Domain::in(int32 x) const
     assert(!overflow_);
     auto it = std::lower_bound(ranges_.begin(), ranges_.end(), x, [](Range r, int x){ return r.u < x; });
     if (it==ranges_.end()) return false;
-    return x >=it->l;
+    return x >=it->l && (int64(x)-it->l)%it->s==0;
+}
+
+bool Domain::operator==(const Domain& d) const
+{
+    if (ranges_==d.ranges_)
+        return true;
+    if (size()!=d.size())
+        return false;
+    return std::equal(begin(),end(),d.begin());
 }
 
 bool Domain::in(const Domain& x) const
@@ -72,67 +323,31 @@ bool Domain::in(const Domain& x) const
 
 bool Domain::constrainDomain(int32 times, int32 c, int32 div)
 {
-    if ((times+c % div ==0) || abs(div)==1) return true;
+    int64 m = std::abs(int64(div));
+    if (m==1) return true;
 
-    Domain n(1,-1);
-
-    if (div< (int64)size())
+    /// the solutions of times*i = -c mod m are i = offset mod period
+    int64 t = posmod(times,m);
+    int64 rhs = posmod(-int64(c),m);
+    int64 g = gcd(t,m);
+    modified_=true;
+    if (rhs%g != 0)
     {
-        /// i can stop after 2 found numbers x,y, then y-x is the period
-        /// of the new set to be created,
-        /// Then I iterate over the ranges,
-        /// and can calculate the rest
-        int count = 0;
-        int first, second;
-        for (int i = 0; i != abs(div); ++i)
-        {
-            if ((i*times + c)%div==0)
-            {
-                ++count;
-                if (count==1)
-                    first=i;
-                else
-                if (count==2)
-                {
-                    second=i;
-                    break;
-                }
-            }
-        }
-
-        if (count>0) // otherwise empty domain
-        {
-            int period;
-            if (count==1)
-                period=abs(div);
-            else
-                period=second-first;
-
-            for (auto& x : ranges_)
-            {
-                int start;
-                int mod =  x.l > 0 ? x.l%period : div - abs(x.l%period);
-                if (first >= mod)
-                    start = x.l + (first%period) - mod;
-                else
-                    start = x.l + (div - mod) + first;
-                while(start<=x.u)
-                {
-                    n.ranges_.emplace_back(Range(start,start));
-                    start += period;
-                }
-            }
-        }
+        ranges_.clear();
+        return false;
     }
-    else
-    {
+    int64 period = m/g;
+    if (period==1) return !empty();
+    int64 offset = posmod(rhs/g * inverse(t/g,period), period);
 
-        for (Domain::const_iterator i = begin(); i != end(); ++i)
-            if ((times*(*i)+c)%div==0)
-                n.ranges_.emplace_back(Range(*i,*i));
+    RangeVec n;
+    for (const auto& r : ranges_)
+    {
+        int64 first, last, stride;
+        if (intersectProgressions(r.l, r.u, r.s, r.l - posmod(r.l-offset,period), r.u, period, first, last, stride))
+            n.emplace_back(first,last,stride);
     }
-    n.ranges_.swap(ranges_);
-    modified_=true;
+    n.swap(ranges_);
     return !empty();
 }
 
@@ -151,14 +366,18 @@ bool Domain::intersect(int32 lower, int32 upper)
     auto it = std::lower_bound(ranges_.begin(), ranges_.end(), lower, [](Range x, int lower){ return x.u < lower; });
     if (it==ranges_.end()) { ranges_.clear(); return false; }
     if (lower >=it->l) // inside the range
-        it->l=lower;
+    {
+        it->l=firstFrom(it->l,it->s,lower);
+        fixStride(*it);
+    }
     it = ranges_.erase(ranges_.begin(), it);
     /// first one that contains the bound or is bigger
     it = std::lower_bound(it, ranges_.end(), upper, [](Range x, int upper){ return x.u < upper; });
     if (it==ranges_.end()) return true;
     if (upper >= it->l) // inside the range
     {
-        it->u=upper;
+        it->u=lastUntil(it->l,it->s,upper);
+        fixStride(*it);
         ranges_.erase(it+1, ranges_.end());
     }
     else
@@ -172,36 +391,20 @@ bool Domain::intersect(const Domain& d)
     modified_=true;
     assert(!overflow_);
     assert(!empty());
-    auto it = ranges_.begin();
-    auto save = ranges_.begin();
-    for (std::vector<Range>::const_iterator i = d.ranges_.begin(); i != d.ranges_.end(); ++i)
-    {
-        int lower = i->l;
-        int upper = i->u;
-
-        /// first one that contains the bound or is bigger
-        it = std::lower_bound(it, ranges_.end(), lower, [](Range x, int lower){ return x.u < lower; });
-        if (it==ranges_.end()) { ranges_.erase(save,ranges_.end()); return !empty(); }
-        if (lower >=it->l) // inside the range
-            it->l=lower;
-        it = ranges_.erase(save, it);
-        /// first one that contains the bound or is bigger
-        it = std::lower_bound(it, ranges_.end(), upper, [](Range x, int upper){ return x.u < upper; });
-        if (it==ranges_.end()) return !empty();
-        if (upper >= it->l) // inside the range
+    RangeVec ret;
+    auto j = d.ranges_.begin();
+    for (const auto& i : ranges_)
+    {
+        while (j != d.ranges_.end() && j->u < i.l)
+            ++j;
+        for (auto k = j; k != d.ranges_.end() && k->l <= i.u; ++k)
         {
-            auto newlower = upper+1;
-            auto newupper = it->u;
-            it->u=upper;
-            if (i+1!=d.ranges_.end())
-                it = ranges_.insert(it+1,Range(newlower,newupper));
-            else
-                ++it;
+            int64 first, last, stride;
+            if (intersectProgressions(i.l, i.u, i.s, k->l, k->u, k->s, first, last, stride))
+                ret.emplace_back(first,last,stride);
         }
-        save = it;
-
     }
-    ranges_.erase(save,ranges_.end());
+    ranges_.swap(ret);
     return !empty();
 }
 
@@ -209,34 +412,31 @@ bool Domain::intersect(const Domain& d)
 bool Domain::remove(int32 x)
 {
     auto found = std::lower_bound(ranges_.begin(),ranges_.end(), x, [](const Range& r, int x){ return r.u < x; });
-    if (found!=ranges_.end())
+    if (found!=ranges_.end() && x>=found->l && (int64(x)-found->l)%found->s==0)
     {
-        if (x>=found->l)
+        modified_=true;
+        if (found->l==found->u)
+            ranges_.erase(found);
+        else
+        if (x==found->l)
         {
-            modified_=true;
-            bool split = true;
-            if (x==found->l)
-            {
-                ++(found->l);
-                split = false;
-            }
-            if (x==found->u)
-            {
-                --(found->u);
-                split = false;
-            }
-            if (found->l>found->u)
-                ranges_.erase(found);
-            if (split)
-            {
-                int oldu = found->u;
-                found->u=x-1;
-                ranges_.insert(found+1,Range(x+1,oldu));
-            }
-            return !empty();
+            found->l+=found->s;
+            fixStride(*found);
+        }
+        else
+        if (x==found->u)
+        {
+            found->u-=found->s;
+            fixStride(*found);
+        }
+        else
+        {
+            Range upper(x+found->s,found->u,found->s);
+            fixStride(upper);
+            found->u=x-found->s;
+            fixStride(*found);
+            ranges_.insert(found+1,upper);
         }
-        return !empty();
-
     }
     return !empty();
 }
@@ -281,18 +481,23 @@ Domain& Domain::inplace_times(int32 n, int64 maxSize)
     if (maxSize==-1 || (int64)(size())<=(int64)(maxSize))
     {
         modified_=true;
-        std::vector<Range> temp;
-        for (auto r: ranges_)
-            for (int i = r.l; i <= r.u; ++i)
+        /// exact, each range becomes a progression
+        for (auto &i : ranges_)
+        {
+            if (int64(i.l)*int64(n)<min || int64(i.u)*int64(n)>max)
             {
-                if (int64(i)*int64(n)>max || int64(i)*int64(n)<min)
-                {
-                    overflow_=true;
-                    return *this;
-                }
-                temp.push_back(Range(i*n,i*n));
+                overflow_=true;
+                return *this;
+            }
+            i.l*=n;
+            i.u*=n;
+            if (i.l!=i.u)
+            {
+                /// the stride is at most u-l, stay on the safe side if it does not fit anyway
+                int64 s = int64(i.s)*int64(n);
+                i.s = s <= std::numeric_limits<int32>::max() ? int32(s) : 1;
             }
-        swap(temp,ranges_);
+        }
     }
     else
     {
@@ -307,6 +512,7 @@ Domain& Domain::inplace_times(int32 n, int64 maxSize)
             }
             i.l*=n;
             i.u*=n;
+            i.s=1;
         }
     }
     return *this;
@@ -324,26 +530,16 @@ Domain& Domain::inplace_divide(int32 n)
     if (n==1) return *this;
 
     modified_=true;
-    Domain d;
-    d.ranges_.clear();
-    auto start = d.ranges_.end();
-
-    for (auto& r : ranges_)
+    RangeVec old;
+    old.swap(ranges_);
+    auto start = ranges_.begin();
+    for (const auto& r : old)
     {
-        int32 old = - Domain::min-1;
-        for (int32 i = r.l; i <= r.u; ++i)
-            if (i%n==0 && (i/n!=old))
-            {
-                start = d.add(start,Range(i/n,i/n));
-                old = i/n;
-            }
-//        int l = r.l <= 0 ? r.l + std::abs(r.l/n) : r.l - std::abs(r.l%n);
-//        int u = r.u <= 0 ? r.u + std::abs(r.u/n) : r.u - std::abs(r.u%n);
-//        if (l>u)
-//            continue;
+        /// only the multiples of n remain
+        int64 first, last, stride;
+        if (intersectProgressions(r.l, r.u, r.s, r.l - posmod(r.l,n), r.u, n, first, last, stride))
+            start = add(start, Range(first/n, last/n, first==last ? 1 : stride/n));
     }
-
-    d.ranges_.swap(ranges_);
     return *this;
 }
 
@@ -376,9 +572,8 @@ Domain& Domain::operator+=(const Domain& d)
     assert(!overflow_);
     modified_=true;
     if (d.size()==1) return *this += d.lower();
-    std::vector<Range> ret;
-    using std::swap;
-    swap(ret,ranges_);
+    RangeVec ret;
+    ret.swap(ranges_);
     for (auto &i : ret)
     {
         for (auto j : d.ranges_)
@@ -388,7 +583,24 @@ Domain& Domain::operator+=(const Domain& d)
                 overflow_=true;
                 return *this;
             }
-            unify(i.l+j.l,i.u+j.u);
+            /// the sum of two progressions is again one if they have the same stride
+            /// or one fills the gaps of the other
+            if (i.l==i.u || j.l==j.u || i.s==j.s)
+                add(ranges_.begin(), Range(i.l+j.l, i.u+j.u, i.l==i.u ? j.s : i.s));
+            else
+            if (j.s%i.s==0 && i.size()*i.s>=j.s)
+                add(ranges_.begin(), Range(i.l+j.l, i.u+j.u, i.s));
+            else
+            if (i.s%j.s==0 && j.size()*j.s>=i.s)
+                add(ranges_.begin(), Range(i.l+j.l, i.u+j.u, j.s));
+            else
+            {
+                /// shift the larger progression by each element of the smaller one
+                const Range& small = i.size() < j.size() ? i : j;
+                const Range& large = i.size() < j.size() ? j : i;
+                for (int64 x = small.l; x <= small.u; x += small.s)
+                    add(ranges_.begin(), Range(large.l+x, large.u+x, large.s));
+            }
         }
     }
     return *this;
@@ -414,60 +626,13 @@ Domain& Domain::operator+=(const int32& d)
 
 
 
-std::vector<Range>::iterator Domain::add(std::vector<Range>::iterator start, const Range& r)
+RangeVec::iterator Domain::add(RangeVec::iterator start, const Range& r)
 {
     assert(!overflow_);
     if (r.l > r.u)
         return start;
     modified_=true;
-    auto it = std::lower_bound(start, ranges_.end(), r, [](Range x, Range y){ return x.u < y.l; });
-    /// we now have an iterator to an element which upper bound is bigger
-    /// than our lower bound
-    /// if it is at the end, we insert us there
-    if (it==ranges_.end())
-    {
-        ranges_.push_back(r);
-        it = ranges_.end()-1;
-    }
-    else
-    {   /// it is actually really bigger
-        if (it->l > r.u+1)
-        {
-            it = ranges_.insert(it,r);
-        }
-        else
-        {
-            // the lower bound is extended
-            if (it->l > r.l)
-                it->l = r.l;
-
-            // the lower bound is already included in the current(it) range
-            if (r.u > it->u) // the upper bound is not yet included and can be expanded
-            {
-                it->u = r.u;
-                auto upTo = it+1;
-                while(upTo!=ranges_.end() && upTo->l<=r.u+1)
-                {
-                    if (upTo->u>it->u)
-                        it->u = upTo->u;
-                    ++upTo;
-                }
-                ranges_.erase(it+1,upTo);
-                //it is not invalid !
-                if (r.u==it->u) ++it;
-            }
-        }
-    }
-
-    /// it was now already inserted, but it can happen that it can merge with
-    /// a range below
-    if (it != ranges_.begin() && (it-1)->u+1 == r.l)
-    {
-        (it-1)->u = it->u;
-        --it;
-        ranges_.erase(it+1);
-    }
-    return it;
+    return addRange(ranges_, start, r);
 }
 
 
@@ -477,7 +642,7 @@ std::vector<Range>::iterator Domain::add(std::vector<Range>::iterator start, con
 Domain::const_iterator& Domain::const_iterator::operator++()
 {
     assert(index_<d_->ranges_.size());
-    if (steps_ < (uint32)(d_->ranges_[index_].u - d_->ranges_[index_].l))
+    if (steps_ < (uint32)(d_->ranges_[index_].size()-1))
         ++steps_;
     else
     {
@@ -497,7 +662,7 @@ Domain::const_iterator& Domain::const_iterator::operator--()
     {
         assert(index_!=0);
         --index_;
-        steps_ = d_->ranges_[index_].u - d_->ranges_[index_].l;
+        steps_ = d_->ranges_[index_].size()-1;
     }
     return *this;
 }
@@ -529,7 +694,7 @@ int64 Domain::const_iterator::operator-(const Domain::const_iterator& m) const
     int64 count= -(int64)m.steps_;
     while(count_index < index_)
     {
-        count+=(int64)(d_->ranges_[count_index].u)-d_->ranges_[count_index].l +1;
+        count+=d_->ranges_[count_index].size();
         ++count_index;
     }
     count+=steps_;
@@ -545,7 +710,7 @@ Domain::const_iterator& Domain::const_iterator::operator+=(int64 x)
     steps_=0;
     while(index_<d_->ranges_.size())
     {
-        uint64 range = (uint64)(d_->ranges_[index_].u) - d_->ranges_[index_].l;
+        uint64 range = d_->ranges_[index_].size()-1;
         if (range<add)
         {
             ++index_;
@@ -572,7 +737,7 @@ Domain::const_iterator& Domain::const_iterator::operator-=(int64 x)
     --index_;
     while(true)
     {
-        uint64 range = (int64)(d_->ranges_[index_].u) - d_->ranges_[index_].l+1;
+        uint64 range = d_->ranges_[index_].size();
         if (range<sub)
         {
             --index_;
@@ -600,45 +765,15 @@ bool ViewDomain::in(int64 x) const
 {
     auto it = std::lower_bound(ranges_.begin(), ranges_.end(), x, [](LongRange r, int64 x){ return r.u < x; });
     if (it==ranges_.end()) return false;
-    return x >=it->l;
+    return x >=it->l && (x-it->l)%it->s==0;
 }
 
 
-std::vector<LongRange>::iterator ViewDomain::add(std::vector<LongRange>::iterator start, const LongRange& r)
+LongRangeVec::iterator ViewDomain::add(LongRangeVec::iterator start, const LongRange& r)
 {
     if (r.l > r.u)
         return start;
-    auto it = std::lower_bound(start, ranges_.end(), r, [](LongRange x, LongRange y){ return x.u+1 < y.l; });
-    if (it==ranges_.end())
-    {
-        ranges_.push_back(r);
-        return ranges_.end();
-    }
-
-    if (it->l > r.u+1)
-    {
-        return ranges_.insert(it,r);
-    }
-    // the lower bound is extended
-    if (it->l > r.l)
-        it->l = r.l;
-    // the lower bound is already included in the current range
-    if (r.u > it->u) // the upper bound is not yet included and can be expanded
-    {
-        it->u = r.u;
-        auto upTo = it+1;
-        while(upTo!=ranges_.end() && upTo->l<=r.u+1)
-        {
-            if (upTo->u>it->u)
-                it->u = upTo->u;
-            ++upTo;
-        }
-        ranges_.erase(it+1,upTo);
-        //it is not invalid !
-        if (r.u==it->u) return it+1;
-        else return it;
-    }
-    return it;
+    return addRange(ranges_, start, r);
 }
 
 
@@ -648,7 +783,7 @@ std::vector<LongRange>::iterator ViewDomain::add(std::vector<LongRange>::iterato
 ViewDomain::const_iterator& ViewDomain::const_iterator::operator++()
 {
     assert(index_<d_->ranges_.size());
-    if (steps_ < (uint64)(d_->ranges_[index_].u - d_->ranges_[index_].l))
+    if (steps_ < (uint64)(d_->ranges_[index_].size()-1))
         ++steps_;
     else
     {
@@ -668,7 +803,7 @@ ViewDomain::const_iterator& ViewDomain::const_iterator::operator--()
     {
         assert(index_!=0);
         --index_;
-        steps_ = d_->ranges_[index_].u - d_->ranges_[index_].l;
+        steps_ = d_->ranges_[index_].size()-1;
     }
     return *this;
 }
@@ -700,7 +835,7 @@ int64 ViewDomain::const_iterator::operator-(const ViewDomain::const_iterator& m)
     int64 count= -(int64)m.steps_;
     while(count_index < index_)
     {
-        count+=(int64)(d_->ranges_[count_index].u)-d_->ranges_[count_index].l +1;
+        count+=d_->ranges_[count_index].size();
         ++count_index;
     }
     count+=steps_;
@@ -717,7 +852,7 @@ ViewDomain::const_iterator& ViewDomain::const_iterator::operator+=(int64 x)
     steps_=0;
     while(true)
     {
-        uint64 range = (uint64)(d_->ranges_[index_].u) - d_->ranges_[index_].l;
+        uint64 range = d_->ranges_[index_].size()-1;
         if (range<(uint64)(add))
         {
             ++index_;
@@ -744,7 +879,7 @@ ViewDomain::const_iterator& ViewDomain::const_iterator::operator-=(int64 x)
     --index_;
     while(true)
     {
-        uint64 range = (int64)(d_->ranges_[index_].u) - d_->ranges_[index_].l+1;
+        uint64 range = d_->ranges_[index_].size();
         if (range<sub)
         {
             --index_;
@@ -797,9 +932,10 @@ ViewIterator lower_bound(ViewIterator first, ViewIterator last, int64 value)
     if (first==last)
         return first;
 
-    int64 diff = std::ceil(double(value - (*first))/std::abs(view.a));
-    if (diff>0)
-        first +=diff;
+    /// the distance of two elements of the current range in the view
+    int64 distance = std::abs(view.a) * first.it_.d_->getRanges()[view.reversed() ? (first.it_-1).index_ : first.it_.index_].s;
+    if (value > *first)
+        first += (value - *first + distance - 1)/distance;
     return first;
 }
 
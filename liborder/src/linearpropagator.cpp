@@ -26,25 +26,92 @@ namespace order
 void ConstraintStorage::addImp(ReifiedLinearConstraint&& l)
 {
     l.normalize();
-    assert(l.l.getRelation()==LinearConstraint::Relation::LE);
-    linearImpConstraints_.emplace_back(std::move(l));
-    auto id = linearImpConstraints_.size()-1;
+    auto& constraints = ownConstraints();
+    constraints.emplace_back(std::move(l));
+    initConstraint(constraints.size()-1);
+}
+
+
+void ConstraintStorage::addImp(const SharedConstraints& vl)
+{
+    if (constraints_->size())
+    {
+        addImp(*vl);
+        return;
+    }
+    constraints_ = vl;
+    own_.reset();
+    for (std::size_t id = 0; id < constraints_->size(); ++id)
+    {
+        assert(constraint(id).l.normalized());
+        initConstraint(id);
+    }
+}
+
+
+void ConstraintStorage::extendImp(const SharedConstraints& vl)
+{
+    assert(vl->size() >= constraints_->size());
+    std::size_t old = constraints_->size();
+    constraints_ = vl;
+    own_.reset();
+    for (std::size_t id = old; id < constraints_->size(); ++id)
+    {
+        assert(constraint(id).l.normalized());
+        initConstraint(id);
+    }
+}
+
+
+std::vector<ReifiedLinearConstraint>& ConstraintStorage::ownConstraints()
+{
+    if (!own_)
+    {
+        own_ = std::make_shared<std::vector<ReifiedLinearConstraint> >(*constraints_);
+        constraints_ = own_;
+    }
+    return *own_;
+}
+
+
+void ConstraintStorage::initConstraint(std::size_t id)
+{
+    const ReifiedLinearConstraint& rl = constraint(id);
+    assert(rl.l.getRelation()==LinearConstraint::Relation::LE);
+    assert(levels_.empty());
+    activities_.emplace_back(computeMinMax(rl.l));
+    stamps_.emplace_back(0);
+    unsigned char bucket = 1;
+    for (auto n = rl.l.getConstViews().size(); n > 1 && bucket < QueueStats::numBuckets-1; n /= 2)
+        ++bucket;
+    sizeBucket_.emplace_back(bucket);
+    reified_.emplace_back(!s_.isTrue(rl.v));
+    queuedFlags_.emplace_back(false);
     queueConstraint(id);
-    for (auto i : l.l.getConstViews())
+    /// a false literal can be unassigned again on backtracking,
+    /// so the constraint is watched like any other reified one
+    if (reified_.back())
+        undecided_.emplace_back(id);
+    auto& minWatches = s_.isTrue(rl.v) ? propWatches_ : reifWatches_;
+    for (auto i : rl.l.getConstViews())
     {
         assert(i.a!=0);
 
         /// can sometimes add a constraint twice for the same variable, should not be a problem
         /// TODO: find a place to call unqiue ?
-        if (!i.reversed())
+        std::size_t index = watchIndex(i.v, i.reversed());
+        /// room for both directions of the variable
+        std::size_t size = watchIndex(i.v, true)+1;
+        if (size > actWatches_.size())
         {
-            lbChanges_.resize(std::max(i.v+1,(unsigned int)(lbChanges_.size())));
-            lbChanges_[i.v].emplace_back(id);
-        }else
-        {
-            ubChanges_.resize(std::max(i.v+1,(unsigned int)(ubChanges_.size())));
-            ubChanges_[i.v].emplace_back(id);
+            propWatches_.resize(size);
+            reifWatches_.resize(size);
+            actWatches_.resize(size);
         }
+        /// a positive coefficient increases the minimum on a lower bound change
+        /// and decreases the maximum on an upper bound change, the opposite for negative ones
+        minWatches[index].emplace_back(id,i.a);
+        actWatches_[watchIndex(i.v, !i.reversed())].emplace_back(id,i.a);
     }
 
 }
@@ -52,7 +119,7 @@ void ConstraintStorage::addImp(ReifiedLinearConstraint&& l)
 void ConstraintStorage::addImp(const std::vector<ReifiedLinearConstraint>& vl)
 {
     for (auto& l : vl)
-        addImp(std::move(ReifiedLinearConstraint(l)));
+        addImp(ReifiedLinearConstraint(l));
 }
 
 
@@ -62,89 +129,206 @@ void ConstraintStorage::addImp(std::vector<ReifiedLinearConstraint>&& vl)
         addImp(std::move(l));
 }
 
+void ConstraintStorage::clearQueue()
+{
+    for (auto& bucket : toProcess_)
+    {
+        for (auto i : bucket)
+            queuedFlags_[i] = false;
+        bucket.clear();
+    }
+    queued_ = 0;
+}
+
+
 void ConstraintStorage::removeLevel()
 {
-    for (auto i: toProcess_)
-        linearImpConstraints_[i].l.setFlag(false);
-    toProcess_.clear();
+    clearQueue();
+    assert(levels_.size());
+    while (activityTrail_.size() > levels_.back().first)
+    {
+        auto& e = activityTrail_.back();
+        activities_[e.id] = e.activity;
+        stamps_[e.id] = e.level;
+        activityTrail_.pop_back();
+    }
+    while (removedWatches_.size() > levels_.back().second)
+    {
+        auto& r = removedWatches_.back();
+        reifWatches_[r.index].emplace_back(r.w);
+        removedWatches_.pop_back();
+    }
+    levels_.pop_back();
 }
 
 
 /// return false if the domain is empty
-void ConstraintStorage::constrainUpperBound(const View &view, const Solver& s)
+void ConstraintStorage::constrainUpperBound(const View &view, const Restrictor& old, const Restrictor& now)
 {
-    Variable v = view.v;
+    assert(old.begin().view()==View(view.v) && now.begin().view()==View(view.v));
+    /// an empty domain is a conflict, the activities are restored when the level is removed
+    if (now.isEmpty())
+        return;
+    changeBounds(view.v, now.lower() - old.lower(), now.upper() - old.upper());
+}
 
-    if (ubChanges_.size()>v)
-    for (auto i : ubChanges_[v])
+
+void ConstraintStorage::changeBounds(Variable v, int64 dl, int64 du)
+{
+    if (watchIndex(v,true) >= actWatches_.size())
+        return;
+
+    if (dl)
     {
-        bool check = (s.isTrue(linearImpConstraints_[i].v) && !view.reversed()) || (s.isFalse(linearImpConstraints_[i].v) && view.reversed());
-        if (check || s.isUnknown(linearImpConstraints_[i].v))
-            queueConstraint(i);
+        std::size_t index = watchIndex(v,false);
+        for (auto i : propWatches_[index])
+        {
+            updateActivity(i.id, i.a*dl, 0);
+            queueConstraint(i.id);
+        }
+        wakeReified(index, dl);
+        for (auto i : actWatches_[index])
+            updateActivity(i.id, 0, i.a*dl);
     }
 
-    if (lbChanges_.size()>v)
-    for (auto i : lbChanges_[v])
+    if (du)
     {
-        bool check = (s.isTrue(linearImpConstraints_[i].v) && view.reversed()) || (s.isFalse(linearImpConstraints_[i].v) && !view.reversed());
-        if (check || s.isUnknown(linearImpConstraints_[i].v))
-            queueConstraint(i);
+        std::size_t index = watchIndex(v,true);
+        for (auto i : propWatches_[index])
+        {
+            updateActivity(i.id, i.a*du, 0);
+            queueConstraint(i.id);
+        }
+        wakeReified(index, du);
+        for (auto i : actWatches_[index])
+            updateActivity(i.id, 0, i.a*du);
     }
 }
 
 /// return false if the domain is empty
-void ConstraintStorage::constrainLowerBound(const View &u, const Solver& s)
+void ConstraintStorage::constrainLowerBound(const View &u, const Restrictor& old, const Restrictor& now)
 {
-    constrainUpperBound(u*-1,s);
+    constrainUpperBound(u*-1,old,now);
 }
 
 
-/// remove all constraints,
-/// moves the list of all reified implications out of the object
-std::vector<ReifiedLinearConstraint> ConstraintStorage::removeConstraints()
+void ConstraintStorage::wakeDecided()
 {
-    auto ret = std::move(linearImpConstraints_);
-    linearImpConstraints_.clear();
-    lbChanges_.clear();
-    ubChanges_.clear();
-    for (auto i : toProcess_)
-        ret[i].l.setFlag(false);
-    toProcess_.clear();
-    return ret;
+    for (std::size_t j = 0; j < undecided_.size();)
+    {
+        std::size_t id = undecided_[j];
+        if (s_.isUnknown(constraint(id).v))
+        {
+            ++j;
+            continue;
+        }
+        if (s_.isTrue(constraint(id).v))
+            queueConstraint(id);
+        undecided_[j] = undecided_.back();
+        undecided_.pop_back();
+    }
 }
 
 
-void ConstraintStorage::queueConstraint(std::size_t id)
+void ConstraintStorage::wakeReified(std::size_t index, int64 d)
 {
-    assert(id < linearImpConstraints_.size());
-    if (!linearImpConstraints_[id].l.getFlag())
+    auto& watches = reifWatches_[index];
+    for (std::size_t j = 0; j < watches.size();)
     {
-        toProcess_.emplace_back(id);
-        if (conf_.sortQueue)
+        Watch w = watches[j];
+        if (s_.isFalse(constraint(w.id).v))
         {
-            std::push_heap(toProcess_.begin(), toProcess_.end(), [this](std::size_t a, std::size_t b)
-            { return linearImpConstraints_[a].l.getConstViews().size() > linearImpConstraints_[b].l.getConstViews().size(); } );
+            /// the activity is no longer maintained, it is restored with the level that removed the watch
+            if (levels_.size())
+                removedWatches_.emplace_back(index,w);
+            watches[j] = watches.back();
+            watches.pop_back();
+            continue;
         }
-        linearImpConstraints_[id].l.setFlag(true);
+        updateActivity(w.id, w.a*d, 0);
+        queueConstraint(w.id);
+        ++j;
     }
+}
+
 
+void ConstraintStorage::updateActivity(std::size_t id, int64 dmin, int64 dmax)
+{
+    if (stamps_[id] != levels_.size()) // first change on this level
+    {
+        activityTrail_.emplace_back(id,stamps_[id],activities_[id]);
+        stamps_[id] = levels_.size();
+    }
+    activities_[id].first += dmin;
+    activities_[id].second += dmax;
 }
 
-std::size_t ConstraintStorage::popConstraint()
+
+std::pair<int64,int64> ConstraintStorage::computeMinMax(const LinearConstraint& l) const
 {
-    size_t ret;
-    if (!conf_.sortQueue)
+    auto& views = l.getViews();
+    std::pair<int64,int64> minmax(0,0);
+    for (auto& i : views)
     {
-        ret = toProcess_.back();
+        auto r = vs_.getCurrentRestrictor(i);
+        minmax.first += r.lower();
+        minmax.second += r.upper();
     }
-    else
+    return minmax;
+}
+
+
+/// remove all constraints,
+/// moves the list of all reified implications out of the object
+std::vector<ReifiedLinearConstraint> ConstraintStorage::removeConstraints()
+{
+    clearQueue();
+    std::vector<ReifiedLinearConstraint> ret = std::move(ownConstraints());
+    own_ = std::make_shared<std::vector<ReifiedLinearConstraint> >();
+    constraints_ = own_;
+    queuedFlags_.clear();
+    propWatches_.clear();
+    reifWatches_.clear();
+    actWatches_.clear();
+    removedWatches_.clear();
+    activities_.clear();
+    activityTrail_.clear();
+    levels_.clear();
+    stamps_.clear();
+    sizeBucket_.clear();
+    reified_.clear();
+    undecided_.clear();
+    return ret;
+}
+
+
+void ConstraintStorage::queueConstraint(std::size_t id)
+{
+    assert(id < constraints_->size());
+    if (!queuedFlags_[id])
     {
-        ret = toProcess_.front();
-        std::pop_heap(toProcess_.begin(), toProcess_.end(), [this](std::size_t a, std::size_t b)
-        { return linearImpConstraints_[a].l.getConstViews().size() > linearImpConstraints_[b].l.getConstViews().size(); } );
+        /// undecided constraints only check if they are violated, which is cheap
+        unsigned int bucket = 0;
+        if (conf_.sortQueue && !(reified_[id] && !s_.isTrue(constraint(id).v)))
+            bucket = sizeBucket_[id];
+        toProcess_[bucket].emplace_back(id);
+        ++queued_;
+        queuedFlags_[id] = true;
     }
-    linearImpConstraints_[ret].l.setFlag(false);
-    toProcess_.pop_back();
+
+}
+
+std::size_t ConstraintStorage::popConstraint()
+{
+    assert(!atFixPoint());
+    lastBucket_ = 0;
+    while (toProcess_[lastBucket_].empty())
+        ++lastBucket_;
+    std::size_t ret = toProcess_[lastBucket_].back();
+    toProcess_[lastBucket_].pop_back();
+    --queued_;
+    ++stats_.wakeups[lastBucket_];
+    queuedFlags_[ret] = false;
     return ret;
 }
 
@@ -154,16 +338,17 @@ bool LinearPropagator::propagateSingleStep()
 {
     if (!storage_.atFixPoint())
     {
-        auto& lc = storage_.linearImpConstraints_[storage_.popConstraint()];
+        auto id = storage_.popConstraint();
+        auto& lc = storage_.constraint(id);
         if (s_.isTrue(lc.v))
         {
-            if (!propagate_true(lc.l))
+            if (!propagate_true(lc.l, id))
                 return false;
         }
         else
         if (s_.isUnknown(lc.v))
         {
-            if (!propagate_impl(lc))
+            if (!propagate_impl(lc, id))
                 return false;
         }
     }
@@ -180,10 +365,45 @@ bool LinearPropagator::propagate()
         if (!propagateSingleStep())
             return false;
     }
+    saveBounds();
     return true;
 }
 
 
+bool LinearPropagator::domainsChanged()
+{
+    propagated_ = false;
+    /// new variables are not restricted by the storage
+    bounds_.resize(vs_.numVariables(), std::make_pair(int64(Domain::min), int64(Domain::max)));
+    if (!vs_.rebase(bounds_))
+        return false;
+    for (std::size_t i = 0; i < vs_.numVariables(); ++i)
+    {
+        if (!vs_.isValid(i))
+            continue;
+        const Restrictor& r = vs_.getCurrentRestrictor(i);
+        storage_.changeBounds(i, r.lower() - bounds_[i].first, r.upper() - bounds_[i].second);
+    }
+    storage_.wakeDecided();
+    saveBounds();
+    return true;
+}
+
+
+void LinearPropagator::saveBounds()
+{
+    bounds_.resize(vs_.numVariables());
+    for (std::size_t i = 0; i < vs_.numVariables(); ++i)
+    {
+        if (vs_.isValid(i))
+        {
+            const Restrictor& r = vs_.getCurrentRestrictor(i);
+            bounds_[i] = std::make_pair(r.lower(), r.upper());
+        }
+    }
+}
+
+
 bool LinearPropagator::propagated() const
 {
     return propagated_;
@@ -196,69 +416,322 @@ bool LinearPropagator::propagated() const
 std::vector<LinearLiteralPropagator::LinearConstraintClause>& LinearLiteralPropagator::propagateSingleStep()
 {
     propClauses_.clear();
-    while (!storage_.atFixPoint() && propClauses_.empty())
+    while (!atFixPoint() && propClauses_.empty())
     {
-        auto& lc = storage_.linearImpConstraints_[storage_.popConstraint()];
+        /// linear constraints are cheaper, alldistinct and disjoint constraints are only propagated at their fixpoint
+        if (storage_.atFixPoint())
+        {
+            std::size_t id = globalQueue_.back();
+            globalQueue_.pop_back();
+            globalQueued_[id] = false;
+            propDistinct_ = id < distincts_->size();
+            propDisjoint_ = !propDistinct_;
+            if (propDistinct_)
+            {
+                propId_ = id;
+                propagateDistinct((*distincts_)[propId_]);
+            }
+            else
+            {
+                propId_ = id - distincts_->size();
+                propagateDisjoint((*disjoints_)[propId_]);
+            }
+            continue;
+        }
+        auto id = storage_.popConstraint();
+        auto& lc = storage_.constraint(id);
+        propId_ = id;
+        propDistinct_ = false;
+        propDisjoint_ = false;
         if (s_.isTrue(lc.v))
-            propagate_true(lc);
+            propagate_true(lc, id);
         else
             if (conf_.propStrength >= 2 && s_.isUnknown(lc.v))
-                propagate_impl(lc);
+                propagate_impl(lc, id);
+        if (propClauses_.empty())
+            storage_.emptyWakeup();
     }
     return propClauses_;
 }
 
 
-std::pair<int64,int64> LinearPropagator::computeMinMax(const LinearConstraint& l)
+void LinearLiteralPropagator::addDistincts(const SharedDistincts& l)
 {
-    auto& views = l.getViews();
-    std::pair<int64,int64> minmax(0,0);
-    for (auto& i : views)
+    assert(distincts_->empty() && disjoints_->empty());
+    distincts_ = l;
+    globalQueued_.assign(distincts_->size(), false);
+    for (std::size_t id = 0; id < distincts_->size(); ++id)
     {
-        auto r = vs_.getCurrentRestrictor(i);
-        minmax.first += r.lower();
-        minmax.second += r.upper();
+        for (const auto& i : (*distincts_)[id].getViews())
+            addGlobalWatch(i.v, id);
+        queueDistinct(id);
     }
-    return minmax;
 }
 
 
-std::pair<int64,int64> LinearLiteralPropagator::computeMinMax(const LinearConstraint& l, itervec& clause)
+void LinearLiteralPropagator::addDisjoints(const SharedDisjoints& l)
 {
-    auto& views = l.getViews();
-    std::pair<int64,int64> minmax(0,0);
+    assert(disjoints_->empty());
+    disjoints_ = l;
+    globalQueued_.resize(distincts_->size() + disjoints_->size(), false);
+    for (std::size_t id = 0; id < disjoints_->size(); ++id)
+    {
+        for (const auto& group : (*disjoints_)[id].getViews())
+            for (const auto& i : group)
+                addGlobalWatch(i.first.v, distincts_->size()+id);
+        queueDisjoint(id);
+    }
+}
 
-    for (auto& i : views)
+
+void LinearLiteralPropagator::addGlobalWatch(Variable v, std::size_t id)
+{
+    if (v >= globalWatches_.size())
+        globalWatches_.resize(v+1);
+    if (globalWatches_[v].empty() || globalWatches_[v].back()!=id)
+        globalWatches_[v].emplace_back(id);
+}
+
+
+void LinearLiteralPropagator::queueGlobal(std::size_t id)
+{
+    assert(id < globalQueued_.size());
+    if (!globalQueued_[id])
     {
-        auto r = vs_.getVariableStorage().getCurrentRestrictor(i);
-        assert(!r.isEmpty());
-        minmax.first += r.lower();
-        minmax.second += r.upper();
-        clause.emplace_back(r.begin());
+        globalQueue_.emplace_back(id);
+        globalQueued_[id] = true;
     }
-    return minmax;
 }
 
-int64 LinearLiteralPropagator::computeMin(const LinearConstraint& l, itervec& clause)
+
+void LinearLiteralPropagator::wakeGlobals(Variable v)
 {
-    auto& views = l.getViews();
-    int64 min(0);
+    if (v < globalWatches_.size())
+        for (auto id : globalWatches_[v])
+            queueGlobal(id);
+}
 
-    for (auto& i : views)
+
+void LinearLiteralPropagator::clearGlobalQueue()
+{
+    for (auto id : globalQueue_)
+        globalQueued_[id] = false;
+    globalQueue_.clear();
+}
+
+
+void LinearLiteralPropagator::addBoundsReason(const View& view, itervec& clause)
+{
+    auto& vs = vs_.getVariableStorage();
+    /// view >= lower and -view >= -upper
+    clause.emplace_back(vs.getCurrentRestrictor(view).begin());
+    clause.emplace_back(vs.getCurrentRestrictor(view*-1).begin());
+}
+
+
+void LinearLiteralPropagator::propagateDistinct(const ReifiedAllDistinct& d)
+{
+    if (s_.isFalse(d.getLiteral()) || (!s_.isTrue(d.getLiteral()) && conf_.propStrength < 2))
+        return;
+    bool prune = s_.isTrue(d.getLiteral());
+    auto& vs = vs_.getVariableStorage();
+    auto& views = d.getViews();
+
+    distinctBounds_.clear();
+    distinctOrder_.clear();
+    for (std::size_t i = 0; i < views.size(); ++i)
+    {
+        auto r = vs.getCurrentRestrictor(views[i]);
+        if (r.isEmpty())
+            return;
+        distinctBounds_.emplace_back(r.lower(), r.upper());
+        distinctOrder_.emplace_back(i);
+    }
+    std::sort(distinctOrder_.begin(), distinctOrder_.end(), [&](std::size_t x, std::size_t y)
+        { return distinctBounds_[x].second < distinctBounds_[y].second; });
+
+    /// for every lower bound a, the views sorted by upper bound b give all intervals [a,b] that can be Hall intervals
+    for (std::size_t start = 0; start < views.size(); ++start)
+    {
+        int64 a = distinctBounds_[start].first;
+        if (std::any_of(distinctBounds_.begin(), distinctBounds_.begin()+start, [a](const std::pair<int64,int64>& x) { return x.first == a; }))
+            continue;
+        std::size_t count = 0;
+        for (std::size_t pos = 0; pos < distinctOrder_.size(); ++pos)
+        {
+            if (distinctBounds_[distinctOrder_[pos]].first < a)
+                continue;
+            ++count;
+            int64 b = distinctBounds_[distinctOrder_[pos]].second;
+            if (pos+1 < distinctOrder_.size() && distinctBounds_[distinctOrder_[pos+1]].second == b)
+                continue;
+            if (count < uint64(b-a+1))
+                continue;
+
+            /// the views in [a,b] need all values of the interval
+            itervec hall;
+            for (std::size_t i = 0; i < views.size(); ++i)
+                if (distinctBounds_[i].first >= a && distinctBounds_[i].second <= b)
+                    addBoundsReason(views[i], hall);
+
+            if (count > uint64(b-a+1))
+            {
+                propClauses_.emplace_back(~d.getLiteral(), std::move(hall));
+                return;
+            }
+            if (!prune)
+                continue;
+
+            /// remove the interval from all other views
+            for (std::size_t i = 0; i < views.size(); ++i)
+            {
+                const auto& bounds = distinctBounds_[i];
+                if ((bounds.first >= a && bounds.second <= b) || bounds.second < a || bounds.first > b)
+                    continue;
+                if (bounds.first < a && bounds.second > b)
+                    continue;
+                auto wholeRange = vs.getRestrictor(views[i]);
+                auto r = vs.getCurrentRestrictor(views[i]);
+                itervec aux(hall);
+                bool conflict = false;
+                if (bounds.first >= a)
+                {
+                    /// view >= a -> view > b
+                    aux.emplace_back(r.begin());
+                    auto reversed = vs.getRestrictor(views[i]*-1);
+                    aux.emplace_back(order::wrap_lower_bound(reversed.begin(), reversed.end(), -b));
+                    auto newLower = order::wrap_upper_bound(r.begin(), wholeRange.end(), b);
+                    conflict = newLower == wholeRange.end() || !constrainLowerBound(newLower);
+                }
+                else
+                {
+                    /// view <= b -> view < a
+                    aux.emplace_back(vs.getCurrentRestrictor(views[i]*-1).begin());
+                    auto newUpper = order::wrap_lower_bound(wholeRange.begin(), r.end(), a);
+                    aux.emplace_back(newUpper);
+                    conflict = newUpper == wholeRange.begin() || !constrainUpperBound(newUpper);
+                }
+                propClauses_.emplace_back(~d.getLiteral(), std::move(aux));
+                if (conflict)
+                    return;
+            }
+            if (!propClauses_.empty())
+                return;
+        }
+    }
+}
+
+
+void LinearLiteralPropagator::computeReason(const LinearConstraint& l, itervec& clause)
+{
+    for (auto& i : l.getViews())
     {
         auto r = vs_.getVariableStorage().getCurrentRestrictor(i);
         assert(!r.isEmpty());
-        min += r.lower();
         clause.emplace_back(r.begin());
     }
-    return min;
 }
 
 
-bool LinearPropagator::propagate_true(const LinearConstraint& l)
+void LinearLiteralPropagator::propagateDisjoint(const ReifiedNormalizedDisjoint& d)
+{
+    if (s_.isFalse(d.getLiteral()) || (!s_.isTrue(d.getLiteral()) && conf_.propStrength < 2))
+        return;
+    bool prune = s_.isTrue(d.getLiteral());
+    auto& vs = vs_.getVariableStorage();
+    auto& groups = d.getViews();
+    propConditions_.clear();
+
+    /// all views with a true condition that have only one value left
+    fixedViews_.clear();
+    for (std::size_t g = 0; g < groups.size(); ++g)
+        for (std::size_t i = 0; i < groups[g].size(); ++i)
+        {
+            if (!s_.isTrue(groups[g][i].second))
+                continue;
+            auto r = vs.getCurrentRestrictor(groups[g][i].first);
+            if (r.isEmpty())
+                return;
+            if (r.size()==1)
+                fixedViews_.emplace_back(r.lower(), std::make_pair(g,i));
+        }
+    if (fixedViews_.empty())
+        return;
+    std::sort(fixedViews_.begin(), fixedViews_.end());
+
+    /// returns a fixed view with value val that is not in group g, or nullptr
+    auto findFixed = [&](int64 val, std::size_t g) -> const std::pair<std::size_t,std::size_t>*
+    {
+        auto it = std::lower_bound(fixedViews_.begin(), fixedViews_.end(), std::make_pair(val, std::make_pair(std::size_t(0),std::size_t(0))));
+        for (; it != fixedViews_.end() && it->first == val; ++it)
+            if (it->second.first != g)
+                return &it->second;
+        return nullptr;
+    };
+
+    for (std::size_t g = 0; g < groups.size(); ++g)
+        for (std::size_t i = 0; i < groups[g].size(); ++i)
+        {
+            const auto& view = groups[g][i].first;
+            Literal cond = groups[g][i].second;
+            if (s_.isFalse(cond))
+                continue;
+            auto r = vs.getCurrentRestrictor(view);
+            if (r.isEmpty())
+                return;
+            bool lower = true;
+            const std::pair<std::size_t,std::size_t>* other = findFixed(r.lower(), g);
+            if (other == nullptr && r.size() > 1)
+            {
+                other = findFixed(r.upper(), g);
+                lower = false;
+            }
+            /// an undecided condition can only be made false if the view is fixed
+            if (other == nullptr || (r.size() > 1 && !s_.isTrue(cond)))
+                continue;
+            /// a true literal or a conflict is needed to derive something
+            bool conflict = s_.isTrue(cond) && r.size()==1;
+            if (!prune && !conflict)
+                continue;
+
+            /// the other view is fixed to the bound of this one
+            itervec clause;
+            addBoundsReason(groups[other->first][other->second].first, clause);
+            LitVec conditions{~groups[other->first][other->second].second, ~cond};
+            if (r.size()==1)
+                addBoundsReason(view, clause);
+            else
+            {
+                if (lower)
+                {
+                    /// view >= v -> view > v
+                    int64 v = r.lower();
+                    clause.emplace_back(r.begin());
+                    auto reversed = vs.getRestrictor(view*-1);
+                    clause.emplace_back(order::wrap_lower_bound(reversed.begin(), reversed.end(), -v));
+                    conflict = !constrainLowerBound(r.begin()+1);
+                }
+                else
+                {
+                    /// view <= v -> view < v
+                    clause.emplace_back(vs.getCurrentRestrictor(view*-1).begin());
+                    clause.emplace_back(r.end()-1);
+                    conflict = !constrainUpperBound(r.end()-1);
+                }
+            }
+            propClauses_.emplace_back(~d.getLiteral(), std::move(clause));
+            propConditions_.emplace_back(std::move(conditions));
+            if (conflict)
+                return;
+        }
+}
+
+
+bool LinearPropagator::propagate_true(const LinearConstraint& l, std::size_t id)
 {
     assert(l.getRelation()==LinearConstraint::Relation::LE);
-    auto minmax = computeMinMax(l);
+    auto minmax = storage_.activity(id);
+    assert(minmax == storage_.computeMinMax(l));
     if (minmax.second <= l.getRhs())
         return true;
 
@@ -284,16 +757,19 @@ bool LinearPropagator::propagate_true(const LinearConstraint& l)
     return true;
 }
 
-void LinearLiteralPropagator::propagate_true(const ReifiedLinearConstraint& rl)
+void LinearLiteralPropagator::propagate_true(const ReifiedLinearConstraint& rl, std::size_t id)
 {
     const LinearConstraint& l = rl.l;
     assert(l.getRelation()==LinearConstraint::Relation::LE);
 
-    propClause_.clear();
-    auto minmax = computeMinMax(l, propClause_);
+    auto minmax = storage_.activity(id);
+    assert(minmax == storage_.computeMinMax(l));
     if (minmax.second <= l.getRhs())
         return;
 
+    propClause_.clear();
+    computeReason(l, propClause_);
+
     if (conf_.propStrength<=2)
     {
         if (minmax.first > l.getRhs())
@@ -371,11 +847,12 @@ void LinearLiteralPropagator::propagate_true(const ReifiedLinearConstraint& rl)
 
 
 
-bool LinearPropagator::propagate_impl(ReifiedLinearConstraint &rl)
+bool LinearPropagator::propagate_impl(const ReifiedLinearConstraint &rl, std::size_t id)
 {
     const LinearConstraint& l = rl.l;
     assert(l.getRelation()==LinearConstraint::Relation::LE);
-    auto minmax = computeMinMax(l);
+    const auto& minmax = storage_.activity(id);
+    assert(minmax == storage_.computeMinMax(l));
 
     if (minmax.first>l.getRhs())
     {
@@ -387,17 +864,19 @@ bool LinearPropagator::propagate_impl(ReifiedLinearConstraint &rl)
 }
 
 
-void LinearLiteralPropagator::propagate_impl(ReifiedLinearConstraint& rl)
+void LinearLiteralPropagator::propagate_impl(const ReifiedLinearConstraint& rl, std::size_t id)
 {
     assert(conf_.propStrength>=2);
     const LinearConstraint& l = rl.l;
     assert(l.getRelation()==LinearConstraint::Relation::LE);
 
     //std::cout << "trying to propagate_impl " << l << std::endl;
-    propClause_.clear();
-    auto min = computeMin(l, propClause_);
+    auto min = storage_.activity(id).first;
+    assert(min == storage_.computeMinMax(l).first);
     if (min>l.getRhs())
     {
+        propClause_.clear();
+        computeReason(l, propClause_);
         /// shrink conflict
         if (conf_.propStrength>=4)
         {
@@ -441,23 +920,33 @@ void LinearLiteralPropagator::propagate_impl(ReifiedLinearConstraint& rl)
 /// return false if the domain is empty
 bool LinearPropagator::constrainUpperBound(const ViewIterator &u)
 {
-    storage_.constrainUpperBound(u.view(),s_);
-    return vs_.constrainUpperBound(u);
+    Restrictor old = vs_.getCurrentRestrictor(u.view().v);
+    bool ret = vs_.constrainUpperBound(u);
+    storage_.constrainUpperBound(u.view(),old,vs_.getCurrentRestrictor(u.view().v));
+    return ret;
 }
 
 
 /// return false if the domain is empty
 bool LinearLiteralPropagator::constrainUpperBound(const ViewIterator &u)
 {
-    storage_.constrainUpperBound(u.view(),s_);
-    return vs_.getVariableStorage().constrainUpperBound(u);
+    auto& vs = vs_.getVariableStorage();
+    Restrictor old = vs.getCurrentRestrictor(u.view().v);
+    bool ret = vs.constrainUpperBound(u);
+    storage_.constrainUpperBound(u.view(),old,vs.getCurrentRestrictor(u.view().v));
+    wakeGlobals(u.view().v);
+    return ret;
 }
 
 /// return false if the domain is empty
 bool LinearLiteralPropagator::constrainLowerBound(const ViewIterator &l)
 {
-    storage_.constrainLowerBound(l.view(),s_);
-    return vs_.getVariableStorage().constrainLowerBound(l);
+    auto& vs = vs_.getVariableStorage();
+    Restrictor old = vs.getCurrentRestrictor(l.view().v);
+    bool ret = vs.constrainLowerBound(l);
+    storage_.constrainLowerBound(l.view(),old,vs.getCurrentRestrictor(l.view().v));
+    wakeGlobals(l.view().v);
+    return ret;
 }
 
 }
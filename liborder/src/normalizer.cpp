@@ -217,7 +217,7 @@ std::pair<bool,bool> Normalizer::deriveSimpleDomain(ReifiedDomainConstraint& d)
         {
             Domain all;
             all.remove(d.getDomain());
-            if (!vc_.intersectView(d.getView(),all))
+            if (!vc_.intersectView(d.getView(),std::move(all)))
                 return std::make_pair(true, false);
             return std::make_pair(true, true);
         }
@@ -287,6 +287,8 @@ bool Normalizer::addDistinct(ReifiedAllDistinct&& l)
     if (conf_.permutation)
         if (!addPermutationConstraint(l))
             return false;
+    if (conf_.alldistinctProp && (l.getDirection()==Direction::FWD || s_.isTrue(l.getLiteral())))
+        return addDistinctPropagator(std::move(l));
     if (conf_.alldistinctCard)
         return addDistinctCardinality(std::move(l));
     //if (conf_.hallsize==0)
@@ -473,6 +475,23 @@ bool Normalizer::addDistinctCardinality(ReifiedAllDistinct&& l)
     return s_.createClause(conditions);
 }
 
+bool Normalizer::addDistinctPropagator(ReifiedAllDistinct&& l)
+{
+    auto& views = l.getViews();
+    if (views.size()<=1) return true;
+
+    uint64 size = 0;
+    ViewDomain d = unify(views,vc_,size);
+
+    if (views.size()>d.size())
+        return s_.createClause(LitVec{~l.getLiteral()});
+    if (size==d.size()) // no overlap between variables
+        return true;
+
+    propagatedDistincts_.emplace_back(std::move(views),l.getLiteral(),Direction::FWD);
+    return true;
+}
+
 bool Normalizer::addDistinctPairwiseUnequal(ReifiedAllDistinct&& l)
 {
     auto& views = l.getViews();
@@ -551,10 +570,11 @@ bool Normalizer::addDomainConstraint(ReifiedDomainConstraint&& d)
     assert(!s_.isFalse(d.getLiteral()) && !s_.isTrue(d.getLiteral()));
     for (const auto &i : d.getDomain().getRanges())
     {
-        if (i.l == i.u)
+        if (i.l == i.u || !onlyProgression(d.getView(),i))
         {
-            Literal u = vc_.getEqualLit(d.getView(),i.l);
-            longc.emplace_back(u);
+            /// a progression is a set of single values
+            for (int64 x = i.l; x <= i.u; x += i.s)
+                longc.emplace_back(vc_.getEqualLit(d.getView(),x));
         }
         else
         {
@@ -587,6 +607,19 @@ bool Normalizer::addDomainConstraint(ReifiedDomainConstraint&& d)
     return true;
 }
 
+bool Normalizer::onlyProgression(const View& v, const Range& r)
+{
+    if (r.s == 1)
+        return true;
+    Restrictor res = vc_.getRestrictor(v);
+    auto it = order::wrap_lower_bound(res.begin(),res.end(),r.l);
+    auto end = order::wrap_upper_bound(it,res.end(),r.u);
+    for (; it != end; ++it)
+        if ((int64(*it)-r.l)%r.s != 0)
+            return false;
+    return true;
+}
+
 bool Normalizer::addDisjoint(ReifiedDisjoint&& l)
 {
     Direction impl = l.getDirection();
@@ -620,6 +653,12 @@ bool Normalizer::addDisjoint(ReifiedDisjoint&& l)
         }
     }
 
+    if (conf_.disjointProp && (impl == Direction::FWD || s_.isTrue(d.getLiteral())))
+    {
+        propagatedDisjoints_.emplace_back(std::move(d));
+        return true;
+    }
+
     /// first vector stores for every tuple
     /// a map having key is the value the variable should take
     /// and DNF as two vectors
@@ -834,8 +873,8 @@ uint64 Normalizer::estimateVariables(const ReifiedDomainConstraint& d)
     Variable v = d.getView().v;
     for (const auto &i : d.getDomain().getRanges())
     {
-        if (i.l == i.u)
-            estimateEQ_[v] = std::min(estimateEQ_[v]+1,allLiterals(v,getVariableCreator()));
+        if (i.l == i.u || !onlyProgression(d.getView(),i))
+            estimateEQ_[v] = std::min(estimateEQ_[v]+(uint64)(i.size()),allLiterals(v,getVariableCreator()));
         else
             ++ret;
         estimateLE_[v] = std::min(estimateLE_[v]+2,allLiterals(v,getVariableCreator()));
@@ -1253,16 +1292,16 @@ bool Normalizer::propagate()
 {
     if (!vc_.restrictDomainsAccordingToLiterals())
         return false;
-    auto temp = std::move(propagator_->removeConstraints());
-    propagator_.reset(new LinearPropagator(s_,vc_,conf_));
-    propagator_->addImp(std::move(temp));
+    /// the propagator is kept between the rounds, it only requeues the constraints
+    /// affected by the domain changes of the last write back and of the master solver
+    if (!propagator_->domainsChanged())
+        return false;
 
-    // do propagate all original constraints
     if(!propagator_->propagate())
     {
         return false;
     }
-    ///update the domain
+    ///update the domain, this invalidates the restrictors of the propagator until the next round
     for (std::size_t i = 0; i < vc_.numVariables(); ++i)
     {
         if (getVariableCreator().isValid(i))
@@ -1299,7 +1338,7 @@ bool Normalizer::finalize()
     if (!vc_.createOrderLiterals())
         return false;
 
-    if (!translate(s_,getVariableCreator(),constraints(),conf_))
+    if (!translate(s_,getVariableCreator(),linearConstraints_,conf_))
         return false;
 
     if (conf_.explicitBinaryOrderClausesIfPossible && !createOrderClauses())
@@ -1313,12 +1352,46 @@ bool Normalizer::finalize()
     /// make all unecessary ones false
     s_.makeRestFalse();
 
+    /// the implications of this step are appended to the ones of the previous steps,
+    /// so that the propagators of the previous step can be extended,
+    /// the shared lists are only replaced if something was added
+    if (linearConstraints_.size())
+    {
+        std::vector<ReifiedLinearConstraint> shared;
+        shared.reserve(sharedConstraints_->size()+linearConstraints_.size());
+        shared.insert(shared.end(), sharedConstraints_->begin(), sharedConstraints_->end());
+        for (auto& i : linearConstraints_)
+        {
+            shared.emplace_back(std::move(i));
+            shared.back().normalize();
+        }
+        linearConstraints_.clear();
+        sharedConstraints_ = std::make_shared<const std::vector<ReifiedLinearConstraint> >(std::move(shared));
+    }
+    if (sharedDistincts_->size() != propagatedDistincts_.size())
+        sharedDistincts_ = std::make_shared<const std::vector<ReifiedAllDistinct> >(propagatedDistincts_);
+    if (sharedDisjoints_->size() != propagatedDisjoints_.size())
+        sharedDisjoints_ = std::make_shared<const std::vector<ReifiedNormalizedDisjoint> >(propagatedDisjoints_);
+
     assert(allDistincts_.size()==0);
     assert(disjoints_.size()==0);
     assert(domainConstraints_.size()==0);
     assert(minimize_.size()==0);
 
     varsAfterFinalize_ = vc_.numVariables();
+    lazyLiterals_.reset(vc_.numVariables());
+    if (conf_.sharedLazyLiterals)
+    {
+        /// free literals that the threads can give a meaning while solving
+        std::vector<Literal> pool;
+        pool.reserve(conf_.sharedLazyLiterals);
+        s_.createNewLiterals(conf_.sharedLazyLiterals);
+        for (unsigned int i = 0; i != conf_.sharedLazyLiterals; ++i)
+            pool.emplace_back(s_.getNewLiteral(true));
+        s_.makeRestFalse();
+        lazyLiterals_.setPool(pool);
+    }
+    activity_.reset(sharedConstraints_->size());
 
     return true;
 }
@@ -1339,111 +1412,113 @@ void Normalizer::variablesWithoutBounds(std::vector<order::Variable>& lb, std::v
 }
 
 
-void Normalizer::convertAuxLiterals(std::vector<const order::VolatileVariableStorage*>& vvss, unsigned int numVars)
+bool Normalizer::convertLazyLiterals(unsigned int numThreads)
 {
-    if (vvss.size()==0)
-        return;
-    if (conf_.convertLazy.second) /// union
+    for (std::size_t i = 0; i != lazyLiterals_.poolSize(); ++i)
     {
-        for (const auto& vvs : vvss)
+        Literal l = lazyLiterals_.poolLiteral(i);
+        Variable var;
+        unsigned int index;
+        if (!lazyLiterals_.poolBound(i, var, index))
         {
-            auto& vc = vvs->getVariableStorage();
-            for (order::Variable var = 0; var != vc.numVariables(); ++var)
-            {
-                unsigned int before = getVariableCreator().numOrderLits(var);
-                unsigned int after = vvs->getStorage(var).numLits()-1;
-                if (after-before==0)
-                    continue;
-                //std::cout << "creating " << after-before << " new literals" << std::endl;
-                s_.createNewLiterals(after-before);
-                order::pure_LELiteral_iterator it(vc.getRestrictor(order::View(var)).begin(),vvs->getStorage(var),true);
-
-                while(it.isValid())
-                {
-                    Literal l = (*it);
-                    if (l.var() > numVars) /// actually comparing clasp variables with order::Literals
-                    {
-                        //std::cout << l.var() << " is an aux var" << std::endl;
-
-                        auto newlit = s_.getNewLiteral(true);
-                        getVariableCreator().setLELit(vc.getRestrictor(order::View(var)).begin()+it.numElement(),newlit);
-                    }
-                    ++it;
-                }
-            }
+            if (!s_.createClause(LitVec{~l}))
+                return false;
+            continue;
         }
+        auto it = vc_.getRestrictor(View(var)).begin()+index;
+        if (!vc_.hasLELiteral(it))
+            vc_.setLELit(it, l);
+        else
+            if (!s_.setEqual(l, vc_.getLELiteral(it)))
+                return false;
     }
-    else
+    if (numThreads==0)
+    {
+        lazyLiterals_.reset(lazyLiterals_.numVariables());
+        return true;
+    }
+    unsigned int needed = conf_.convertLazy.second ? 1 : numThreads;
+    std::vector<std::pair<Variable,unsigned int> > convert;
+    for (Variable var = 0; var != lazyLiterals_.numVariables(); ++var)
     {
-        /// intersection
-        /// for each variable
-        for (order::Variable var = 0; var != vc_.numVariables(); ++var)
+        if (!vc_.isValid(var))
+            continue;
+        auto begin = vc_.getRestrictor(View(var)).begin();
+        lazyLiterals_.forEach(var, [&](unsigned int index, unsigned int count)
         {
-            unsigned int before = getVariableCreator().numOrderLits(var);
-
-            ///compute the thread with the fewest literals
-            unsigned int smallest = 0;
-
-            unsigned int size=std::numeric_limits<unsigned int>::max();
-            unsigned int minimumLits = std::numeric_limits<unsigned int>::max(); /// the minimum number of lits to be added
-            for (unsigned int i = 0; i != vvss.size(); ++i)
-            {
-                unsigned int nl = vvss[i]->getStorage(var).numLits()-1;
-                if (vvss[i]->getStorage(var).numLits()<size)
-                {
-                    smallest = i;
-                    size = nl;
-
-                }
-                minimumLits = std::min(minimumLits,nl-before);
-            }
-            if (!minimumLits)
-                continue;
-
-            const VolatileVariableStorage* smallestVVS= vvss[smallest];
-            auto& vc = smallestVVS->getVariableStorage();
-
-            s_.createNewLiterals(minimumLits);
-
-            order::pure_LELiteral_iterator it(vc.getRestrictor(order::View(var)).begin(),smallestVVS->getStorage(var),true);
+            if (count >= needed && !vc_.hasLELiteral(begin+index))
+                convert.emplace_back(var,index);
+        });
+    }
+    if (convert.size())
+    {
+        s_.createNewLiterals(convert.size());
+        for (const auto& i : convert)
+            vc_.setLELit(vc_.getRestrictor(View(i.first)).begin()+i.second, s_.getNewLiteral(true));
+        s_.makeRestFalse();
+    }
+    lazyLiterals_.reset(lazyLiterals_.numVariables());
+    return true;
+}
 
-            while(it.isValid())
-            {
-                if (smallestVVS->getStorage(var).getLiteral(it.numElement()).var()>numVars) // aux var
-                {
-                    bool found = true;
-                    /// check for all other threads if there is a literal at it position
-                    for (unsigned int i = 0; i!=smallest && i != vvss.size(); ++i)
-                    {
-                        if (vvss[i]->getStorage(var).hasNoLiteral(it.numElement()))
-                        {
-                            found = false;
-                            break;
-                        }
-                    }
-
-                    assert(getVariableCreator().getStorage(var).hasNoLiteral(it.numElement()));
-
-                    if (found)
-                    {
-                        //std::cout << "\033[1;31m" << "added " << var << " on pos " << it.numElement() << "\033[0m" << std::endl;
-                        auto newlit = s_.getNewLiteral(true);
-                        getVariableCreator().setLELit(vc.getRestrictor(order::View(var)).begin()+it.numElement(),newlit);
-                    }
-                }
-                ++it;
-            }
-            /// loop through the literals
-            ///
-            ///
-            s_.makeRestFalse();
-        }
+bool Normalizer::translateHotConstraints()
+{
+    assert(activity_.size()==sharedConstraints_->size());
+    if (conf_.translateHot.first==0)
+        return true;
+    /// (count, index) of all constraints that are active enough, the most active first
+    std::vector<std::pair<unsigned int,std::size_t> > hot;
+    for (std::size_t i = 0; i != activity_.size(); ++i)
+    {
+        unsigned int count = activity_.count(i);
+        if (count && count >= conf_.translateHot.second)
+            hot.emplace_back(count,i);
+    }
+    activity_.reset(activity_.size());
+    if (hot.empty())
+        return true;
+    std::sort(hot.begin(), hot.end(), [](const std::pair<unsigned int,std::size_t>& a, const std::pair<unsigned int,std::size_t>& b)
+    { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+    int64 budget = conf_.translateHot.first;
+    Translator t(s_, conf_);
+    std::vector<bool> translated(sharedConstraints_->size(), false);
+    std::size_t numTranslated = 0;
+    for (const auto& i : hot)
+    {
+        const ReifiedLinearConstraint& rl = (*sharedConstraints_)[i.second];
+        const LinearConstraint& l = rl.l;
+        if (!l.productOfDomainsExceptLastLEx(vc_,budget))
+            continue;
+        if (budget >= 0)
+            budget -= l.productOfDomainsExceptLast(vc_);
+        if (!t.doTranslate(vc_,rl))
+            return false;
+        translated[i.second] = true;
+        ++numTranslated;
     }
+    if (!t.flush())
+        return false;
+    s_.makeRestFalse();
+    if (numTranslated == 0)
+        return true;
+
+    /// the remaining implications keep their order, the list is copied as the propagators may still share the old one
+    std::vector<ReifiedLinearConstraint> shared;
+    shared.reserve(sharedConstraints_->size()-numTranslated);
+    for (std::size_t i = 0; i != sharedConstraints_->size(); ++i)
+        if (!translated[i])
+            shared.emplace_back((*sharedConstraints_)[i]);
+    sharedConstraints_ = std::make_shared<const std::vector<ReifiedLinearConstraint> >(std::move(shared));
+    ++constraintEpoch_;
+    activity_.reset(sharedConstraints_->size());
+    return true;
 }
 
 bool Normalizer::createOrderClauses()
 {
     /// how to decide this incrementally?  recreate per var ?
+    ClauseBuffer clauses(s_);
     for (Variable var = 0; var <vc_.numVariables(); ++var)
     {
         if (getVariableCreator().isValid(var))
@@ -1459,7 +1534,7 @@ bool Normalizer::createOrderClauses()
                     auto old = next;
                     ++next;
                     if (old.isValid() && next.isValid() && old.numElement()+1 == next.numElement())
-                        if (!s_.createClause(LitVec{~(*old),*next}))
+                        if (!clauses.add({~(*old),*next}))
                             return false;
                     //if (vc_.hasLELiteral(v) && vc_.hasLELiteral(v+1))
                     //if (!s_.createClause(LitVec{~(vc_.getLELiteral(v)),vc_.getLELiteral(v+1)}))// could use GELiteral instead
@@ -1469,7 +1544,7 @@ bool Normalizer::createOrderClauses()
             }
         }
     }
-    return true;
+    return clauses.flush();
 }
 
 bool Normalizer::createEqualClauses()
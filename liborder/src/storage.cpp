@@ -31,7 +31,7 @@ namespace order
 bool VariableCreator::constrainDomain(const Variable& v, int32 times, int32 c, int32 div)
 {
     assert(isValid(v));
-    if ((times+c % div ==0) || (div==1)) return true;
+    if (std::abs(div)==1) return true;
     std::unique_ptr<Domain> copy(new Domain(*domains_[v]));
     if (!copy->constrainDomain(times, c, div))
         return false;
@@ -135,20 +135,20 @@ std::pair<bool,Literal> VariableCreator::hasEqualLit(Restrictor::ViewIterator it
     ViewDomain d = getViewDomain(it.view());
     if (!d.in(*it))
         return std::make_pair(true,s_.falseLit());
-    auto f = equalLits_.find(std::make_pair(v,*it));
-    if (f!= equalLits_.end())
-        return std::make_pair(true,f->second);
-    else
+    if (v < equalLits_.size())
     {
-        /// if it is the lowest value in the domain
-        /// then le and eq are equal
-        if (d.lower()==*it && hasLELiteral(it))
-            return std::make_pair(true,getLELiteral(it));
-        if (d.upper()==*it && hasGELiteral(it))
-            return std::make_pair(true,getGELiteral(it));
-
-        return std::make_pair(false,s_.trueLit());
+        auto f = equalLits_[v].find(*it);
+        if (f != equalLits_[v].end())
+            return std::make_pair(true,f->second);
     }
+    /// if it is the lowest value in the domain
+    /// then le and eq are equal
+    if (d.lower()==*it && hasLELiteral(it))
+        return std::make_pair(true,getLELiteral(it));
+    if (d.upper()==*it && hasGELiteral(it))
+        return std::make_pair(true,getGELiteral(it));
+
+    return std::make_pair(false,s_.trueLit());
 }
 
 
@@ -169,12 +169,24 @@ bool VariableCreator::setEqualLit(Restrictor::ViewIterator it, Literal l)
             return setLELit(it,l);
         if (it.numElement()==getDomainSize(it.view()) - 1)
             return setGELit(it,l);
-        equalLits_.insert(std::make_pair(std::make_pair(it.view().v,*it), l));
+        addEqualLit(it.view().v,*it,l);
         return true;
     }
 }
 
 
+void VariableCreator::addEqualLit(Variable v, int32 i, Literal l)
+{
+    if (v >= equalLits_.size())
+        equalLits_.resize(numVariables());
+    assert(equalLits_[v].find(i)==equalLits_[v].end());
+    equalLits_[v].emplace(i,l);
+    newEqualLits_.emplace_back(v,i);
+    undecidedEqualLits_.emplace_back(v,i);
+    ++numEqualLits_;
+}
+
+
 bool VariableCreator::createOrderLiterals()
 {
     orderLitMemory_.resize(numVariables());
@@ -258,28 +270,93 @@ bool VariableCreator::restrictDomainsAccordingToLiterals()
                 return false;
         }
     }
-    for (auto i = equalLits_.begin(); i != equalLits_.end();)
+    /// only the equality literals that were undecided last time can change
+    /// constraining a view may add new equality literals, they are visited in the same pass
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < undecidedEqualLits_.size(); ++i)
     {
-        if (s_.isTrue(i->second))
+        const auto e = undecidedEqualLits_[i];
+        auto f = equalLits_[e.first].find(e.second);
+        if (f == equalLits_[e.first].end())
+            continue;
+        Literal l = f->second;
+        if (s_.isTrue(l))
         {
-            if (!constrainView(View(i->first.first),i->first.second,i->first.second))
+            if (!constrainView(View(e.first),e.second,e.second))
                 return false;
-            equalLits_.erase(i++);
         }else
-        if (s_.isFalse(i->second))
+        if (s_.isFalse(l))
         {
-            if (!removeFromView(View(i->first.first),i->first.second))
+            if (!removeFromView(View(e.first),e.second))
                 return false;
-            equalLits_.erase(i++);
         }
         else
-            ++i;
-
+        {
+            undecidedEqualLits_[keep++] = e;
+            continue;
+        }
+        equalLits_[e.first].erase(e.second);
+        --numEqualLits_;
     }
+    undecidedEqualLits_.resize(keep);
     return true;
 }
 
 
+std::pair<SparseLitMap::const_iterator,bool> SparseLitMap::insert(const value_type& v)
+{
+    if (chunks_.empty())
+    {
+        chunks_.emplace_back(1,v);
+        firsts_.emplace_back(v.first);
+        ++size_;
+        return std::make_pair(begin(),true);
+    }
+    std::size_t c = chunkOf(v.first);
+    auto& ch = chunks_[c];
+    auto it = std::lower_bound(ch.begin(), ch.end(), v.first, [](const value_type& e, unsigned int i) { return e.first < i; });
+    std::size_t pos = it - ch.begin();
+    if (it != ch.end() && it->first == v.first)
+        return std::make_pair(const_iterator(this,c,pos),false);
+    ch.insert(it,v);
+    ++size_;
+    if (v.first < firsts_[c])
+        firsts_[c] = v.first;
+    if (ch.size() > maxChunk)
+    {
+        /// split the chunk in halves
+        std::size_t half = ch.size()/2;
+        std::vector<value_type> upper(ch.begin()+half, ch.end());
+        ch.erase(ch.begin()+half, ch.end());
+        firsts_.insert(firsts_.begin()+c+1, upper.front().first);
+        chunks_.insert(chunks_.begin()+c+1, std::move(upper));
+        if (pos >= half)
+        {
+            ++c;
+            pos -= half;
+        }
+    }
+    return std::make_pair(const_iterator(this,c,pos),true);
+}
+
+
+SparseLitMap::const_iterator SparseLitMap::erase(const_iterator it)
+{
+    auto& ch = chunks_[it.chunk_];
+    ch.erase(ch.begin()+it.pos_);
+    --size_;
+    if (ch.empty())
+    {
+        chunks_.erase(chunks_.begin()+it.chunk_);
+        firsts_.erase(firsts_.begin()+it.chunk_);
+        return const_iterator(this,it.chunk_,0);
+    }
+    if (it.pos_ == ch.size())
+        return const_iterator(this,it.chunk_+1,0);
+    return it;
+}
+
+
 Literal VariableCreator::createEqualLit(Restrictor::ViewIterator it)
 {
     it = ViewIterator::viewToVarIterator(it);
@@ -291,29 +368,38 @@ Literal VariableCreator::createEqualLit(Restrictor::ViewIterator it)
         return getGELiteral(it);
     Literal aux = s_.getNewLiteral(true);
     aux.clearFlag(); /// i do need to introduce clauses for this
-    equalLits_.insert(std::make_pair(std::make_pair(it.view().v,*it), aux));
+    addEqualLit(it.view().v,*it,aux);
     return aux;
 }
 
 
 bool VariableCreator::createEqualClauses()
 {
-    for (auto& i : equalLits_)
+    ClauseBuffer clauses(s_);
+    /// sorted to visit the domains in order
+    std::sort(newEqualLits_.begin(), newEqualLits_.end());
+    std::vector<std::pair<Variable,int32> > todo;
+    todo.swap(newEqualLits_);
+    for (const auto& i : todo)
     {
-        Variable v = i.first.first;
-        int value =  i.first.second;
-        Literal l  =  i.second;
+        Variable v = i.first;
+        int value =  i.second;
+        auto f = equalLits_[v].find(value);
+        /// already removed by restrictDomainsAccordingToLiterals
+        if (f == equalLits_[v].end())
+            continue;
+        Literal l  =  f->second;
         if (l.flagged())
             continue;
 
-        i.second.flag();  /// mark as already proceeded
+        f->second.flag();  /// mark as already proceeded
         const auto res = getRestrictor(View(v));
         Literal a(s_.trueLit()); // shall be    x <= v    (exact)
         Literal b(s_.falseLit()); // shall be    x <= v-1  (or lower)
         const auto found = order::wrap_lower_bound(res.begin(), res.end(), value);
         if (found==res.end() || (*found)!=value) /// if out of range or in a hole
         {
-            if (!s_.createClause(LitVec{~l}))
+            if (!clauses.add({~l}))
                 return false;
             continue;
         }
@@ -326,14 +412,14 @@ bool VariableCreator::createEqualClauses()
 
         b = ~getGELiteral(found);
 
-        if (!s_.createClause({l,~a,b}))
+        if (!clauses.add({l,~a,b}))
             return false;
-        if (!s_.createClause({~l,~b}))
+        if (!clauses.add({~l,~b}))
             return false;
-        if (!s_.createClause({~l,a}))
+        if (!clauses.add({~l,a}))
             return false;
     }
-    return true;
+    return clauses.flush();
 }
 
 void VariableCreator::prepareOrderLitMemory()
@@ -349,19 +435,14 @@ void VariableCreator::prepareOrderLitMemory(const Variable& var, std::size_t siz
 {
     if (!hasOrderLitMemory(var))
     {
-        ///TODO: what about the 50 here
-        /// on lazy literals we always have the map in the beginning if the variable domain is > 50
+        /// on lazy literals we start with the sparse map,
+        /// it is dropped once it gets dense (see orderStorage::setLiteral),
+        /// small domains keep the vector beside it for constant time lookups,
+        /// if all literals are created, we directly use the vector
         if (conf_.minLitsPerVar >= 0 && size>0)
-        {
             orderLitMemory_[var].useMap();
-        }
-
-        /// we have the vector if we are not lazy
-        /// if we are lazy we only have it for small sizes
-        if (size<1000000 || conf_.minLitsPerVar == -1)
-        {
+        if (size < orderStorage::denseSize || !orderLitMemory_[var].hasMap())
             orderLitMemory_[var].useVector();
-        }
 
         orderLitMemory_[var].setSize(size);
         orderLitMemory_[var].setLiteral(size-1,s_.trueLit());
@@ -657,24 +738,67 @@ VariableStorage::VariableStorage(const std::vector<std::unique_ptr<Domain> >& do
 void VariableStorage::init()
 {
     addLevel();
+    rs_.reserve(numVariables());
+    stamps_.resize(numVariables(),0);
     for (std::size_t i = 0; i < numVariables(); ++i)
     {
-        rs_.emplace_back();
         if (isValid(i))
-        {
-            rs_.back().emplace_back(getRestrictor(View(i)));
-            levelSets_.back().insert(i);
-        }
+            rs_.emplace_back(getRestrictor(View(i)));
+        else
+            rs_.emplace_back();
     }
 }
 
 
 void VariableStorage::removeLevel()
 {
-    assert(levelSets_.size());
-    for (auto i : levelSets_.back())
-        rs_[i].pop_back();
-    levelSets_.pop_back();
+    assert(levels_.size());
+    while (trail_.size() > levels_.back())
+    {
+        const TrailEntry& e = trail_.back();
+        rs_[e.v] = e.r;
+        stamps_[e.v] = e.level;
+        trail_.pop_back();
+    }
+    levels_.pop_back();
+}
+
+
+void VariableStorage::extend()
+{
+    assert(levels_.size()==1);
+    assert(trail_.empty());
+    for (std::size_t i = rs_.size(); i < numVariables(); ++i)
+    {
+        if (isValid(i))
+            rs_.emplace_back(getRestrictor(View(i)));
+        else
+            rs_.emplace_back();
+    }
+    stamps_.resize(numVariables(),0);
+}
+
+
+bool VariableStorage::rebase(const std::vector<std::pair<int64,int64> >& bounds)
+{
+    assert(levels_.size()==1);
+    assert(bounds.size()>=numVariables());
+    trail_.clear();
+    /// variables may have been created in the meantime
+    rs_.resize(numVariables());
+    stamps_.resize(numVariables(),0);
+    for (std::size_t i = 0; i < numVariables(); ++i)
+    {
+        if (!isValid(i))
+            continue;
+        Restrictor r = getRestrictor(View(i));
+        auto begin = order::wrap_lower_bound(r.begin(), r.end(), bounds[i].first);
+        auto end = order::wrap_upper_bound(begin, r.end(), bounds[i].second);
+        rs_[i] = Restrictor(begin,end);
+        if (rs_[i].isEmpty())
+            return false;
+    }
+    return true;
 }
 
 
@@ -684,15 +808,16 @@ void VariableStorage::constrainVariable(const Restrictor& r)
     assert(r.begin().view().c==0);
     Variable v = r.begin().view().v;
     assert(isValid(v));
-    assert(levelSets_.size());
-    assert(r.begin()>=rs_[v].back().begin());
-    assert(r.end()<=rs_[v].back().end());
-    assert(r.isSubsetEQOf(rs_[v].back()));
-    auto ret = levelSets_.back().insert(v);
-    if (ret.second) // has newly been inserted
-        rs_[v].emplace_back(r);
-    else
-        rs_[v].back() = r;
+    assert(levels_.size());
+    assert(r.begin()>=rs_[v].begin());
+    assert(r.end()<=rs_[v].end());
+    assert(r.isSubsetEQOf(rs_[v]));
+    if (stamps_[v] != levels_.size()) // first change on this level
+    {
+        trail_.emplace_back(v,stamps_[v],rs_[v]);
+        stamps_[v] = levels_.size();
+    }
+    rs_[v] = r;
 }
 
 
@@ -722,4 +847,122 @@ bool VolatileVariableStorage::setGELit(const Restrictor::ViewIterator& it, Liter
     return true;
 }
 
+
+
+void LazyLiteralRegistry::reset(std::size_t numVars)
+{
+    for (std::size_t var = 0; var != numVars_; ++var)
+    {
+        Block* b = heads_[var].load(std::memory_order_relaxed);
+        while (b != nullptr)
+        {
+            Block* next = b->next;
+            delete b;
+            b = next;
+        }
+    }
+    numVars_ = numVars;
+    heads_.reset(numVars ? new std::atomic<Block*>[numVars] : nullptr);
+    for (std::size_t var = 0; var != numVars_; ++var)
+        heads_[var].store(nullptr, std::memory_order_relaxed);
+    setPool(std::vector<Literal>());
+}
+
+
+void LazyLiteralRegistry::setPool(const std::vector<Literal>& pool)
+{
+    pool_ = pool;
+    owners_.reset(pool_.size() ? new std::atomic<uint64>[pool_.size()] : nullptr);
+    for (std::size_t i = 0; i != pool_.size(); ++i)
+        owners_[i].store(0, std::memory_order_relaxed);
+    nextPool_.store(0, std::memory_order_relaxed);
+}
+
+
+LazyLiteralRegistry::Block& LazyLiteralRegistry::block(Variable var, unsigned int index)
+{
+    assert(var < numVars_);
+    unsigned int base = index - index%blockSize;
+    std::atomic<Block*>& head = heads_[var];
+    Block* first = head.load(std::memory_order_acquire);
+    Block* fresh = nullptr;
+    while (true)
+    {
+        for (Block* b = first; b != nullptr; b = b->next)
+        {
+            if (b->base == base)
+            {
+                delete fresh;
+                return *b;
+            }
+        }
+        /// no block for this index yet, try to prepend a new one,
+        /// on failure first is updated to the new head and we search again
+        if (fresh == nullptr)
+            fresh = new Block(base);
+        fresh->next = first;
+        if (head.compare_exchange_weak(first, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+            return *fresh;
+    }
+}
+
+
+unsigned int LazyLiteralRegistry::mark(Variable var, unsigned int index)
+{
+    Block& b = block(var,index);
+    return b.count[index-b.base].fetch_add(1, std::memory_order_relaxed)+1;
+}
+
+
+bool LazyLiteralRegistry::share(Variable var, unsigned int index, Literal& l)
+{
+    if (pool_.empty())
+        return false;
+    Block& b = block(var,index);
+    std::atomic<uint64>& slot = b.shared[index-b.base];
+    uint64 current = slot.load(std::memory_order_acquire);
+    uint64 key = ((uint64(var) << 32) | index)+1;
+    while (current == 0)
+    {
+        std::size_t i = nextPool_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= pool_.size())
+            return false;
+        /// the pool literal gets its bound before it is published,
+        /// it may have been closed by a thread that checks a model
+        uint64 free = 0;
+        if (!owners_[i].compare_exchange_strong(free, key, std::memory_order_acq_rel))
+            continue;
+        /// if another thread was faster, both pool literals stand for the same bound
+        if (slot.compare_exchange_strong(current, i+1, std::memory_order_acq_rel, std::memory_order_acquire))
+            current = i+1;
+    }
+    l = pool_[current-1];
+    return true;
+}
+
+
+bool LazyLiteralRegistry::poolBound(std::size_t i, Variable& var, unsigned int& index)
+{
+    assert(i < pool_.size());
+    uint64 owner = 0;
+    if (owners_[i].compare_exchange_strong(owner, closed, std::memory_order_acq_rel))
+        return false;
+    if (owner == closed)
+        return false;
+    var = Variable((owner-1) >> 32);
+    index = (unsigned int)((owner-1) & 0xFFFFFFFFu);
+    return true;
+}
+
+
+unsigned int LazyLiteralRegistry::count(Variable var, unsigned int index) const
+{
+    assert(var < numVars_);
+    unsigned int base = index - index%blockSize;
+    for (const Block* b = heads_[var].load(std::memory_order_acquire); b != nullptr; b = b->next)
+        if (b->base == base)
+            return b->count[index-base].load(std::memory_order_relaxed);
+    return 0;
+}
+
 }
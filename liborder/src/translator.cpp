@@ -20,6 +20,8 @@
 
 #include <order/translator.h>
 #include <order/solver.h>
+#include <atomic>
+#include <thread>
 
 namespace order
 {
@@ -62,21 +64,28 @@ namespace {
 class ClauseChecker
 {
 public:
-    ClauseChecker(CreatingSolver& s, const Config& conf, VariableCreator& vc) : s_(s), check_(conf.redundantClauseCheck), vc_(vc) {}
+    /// adds the clauses to s, creating their order literals in vc
+    ClauseChecker(ClauseBuffer& s, const Config& conf, VariableCreator& vc) : s_(&s), check_(conf.redundantClauseCheck), vc_(&vc), out_(nullptr) {}
+    /// only stores the iterators of the nogoods in out, neither touches the solver nor the order literals
+    ClauseChecker(const Config& conf, TranslatedClauses& out) : s_(nullptr), check_(conf.redundantClauseCheck), vc_(nullptr), out_(&out) {}
     void emplace_back(const Literal& l) { currentClause_.emplace_back(l); }
     void add(Restrictor::ViewIterator& i)
     {
-        currentClause_.emplace_back(~vc_.getGELiteral(i));
-        if(check_)
+        if (vc_)
+            currentClause_.emplace_back(~vc_->getGELiteral(i));
+        if(check_ || out_)
             currentIterators_.emplace_back(i);
     }
 
 
     void pop_back()
     {
-        assert(currentClause_.size()>1);/// first literal should never be popped
-        currentClause_.pop_back();
-        if(check_)
+        if (vc_)
+        {
+            assert(currentClause_.size()>1);/// first literal should never be popped
+            currentClause_.pop_back();
+        }
+        if(check_ || out_)
             currentIterators_.pop_back();
     }
 
@@ -85,7 +94,7 @@ public:
     {
         if(check_)
         {
-            assert(lastIterators_.empty() || (currentClause_.size() == currentIterators_.size()+1));
+            assert(lastIterators_.empty() || !vc_ || (currentClause_.size() == currentIterators_.size()+1));
             bool relaxed = false;
             bool restrictive = false;
             if (lastIterators_.size()<currentIterators_.size()) restrictive = true;
@@ -115,16 +124,23 @@ public:
 
             lastIterators_ = currentIterators_;
         }
-        return s_.createClause(currentClause_);
+        if (out_)
+        {
+            out_->its.insert(out_->its.end(), currentIterators_.begin(), currentIterators_.end());
+            out_->ends.emplace_back(out_->its.size());
+            return true;
+        }
+        return s_->add(currentClause_);
     }
 private:
 
-    CreatingSolver& s_;
+    ClauseBuffer* s_;
     LitVec currentClause_; // the clause currently building up
     std::vector<Restrictor::ViewIterator> currentIterators_; // the current iterator set representing the currentClause_
     std::vector<Restrictor::ViewIterator> lastIterators_;
     bool check_; // true if redundant clause check is enabled
-    VariableCreator& vc_;
+    VariableCreator* vc_; // nullptr if the nogoods are only stored
+    TranslatedClauses* out_; // the stored nogoods, nullptr if the clauses are created directly
 
 };
 
@@ -183,30 +199,127 @@ private:
 
 };
 
-}
-
-bool Translator::doTranslateImplication(VariableCreator &vc, Literal l, const LinearConstraint& c)
+/// the minimum and maximum of the sum of the views i..n for each i, followed by (0,0)
+std::vector<std::pair<int64,int64> > subsums(const VariableCreator &vc, const LinearConstraint& c)
 {
-    ClauseChecker clause(s_, conf_, vc);
-    clause.emplace_back(~l);
     auto& views = c.getViews();
 
     std::pair<int64,int64> minmax(0,0);
-    std::vector<std::pair<int64,int64> > subsums;
+    std::vector<std::pair<int64,int64> > ret;
     for (std::size_t i = views.size(); i-->0;)
     {
         auto r = vc.getViewDomain(views[i]);
         minmax.first += r.lower();
         minmax.second += r.upper();
-        subsums.emplace_back(minmax);
+        ret.emplace_back(minmax);
     }
-    std::reverse(subsums.begin(),subsums.end());
-    subsums.emplace_back(std::make_pair(0,0));
+    std::reverse(ret.begin(),ret.end());
+    ret.emplace_back(std::make_pair(0,0));
+    return ret;
+}
 
-    RecTrans r(vc,c,subsums,clause);
+}
+
+bool Translator::doTranslateImplication(VariableCreator &vc, Literal l, const LinearConstraint& c)
+{
+    ClauseChecker clause(clauses_, conf_, vc);
+    clause.emplace_back(~l);
+    auto sums = subsums(vc,c);
+
+    RecTrans r(vc,c,sums,clause);
     if (!r.recTrans(0, 0))
         return false;
     return true;
 }
 
+
+void Translator::doTranslate(const VariableCreator &vc, const ReifiedLinearConstraint& l, TranslatedClauses& out) const
+{
+    out.v = l.v;
+    ClauseChecker clause(conf_, out);
+    auto sums = subsums(vc,l.l);
+    RecTrans r(vc,l.l,sums,clause);
+    r.recTrans(0, 0);
+}
+
+
+bool Translator::commit(VariableCreator &vc, const TranslatedClauses& c)
+{
+    LitVec clause;
+    auto begin = c.its.begin();
+    for (auto end : c.ends)
+    {
+        clause.clear();
+        clause.emplace_back(~c.v);
+        for (; begin != c.its.begin()+end; ++begin)
+            clause.emplace_back(~vc.getGELiteral(*begin));
+        if (!clauses_.add(clause))
+            return false;
+    }
+    return true;
+}
+
+
+bool translate(CreatingSolver& s, VariableCreator& vc, std::vector<ReifiedLinearConstraint>& rl, const Config& conf)
+{
+    Translator t(s, conf);
+
+    uint64 size = conf.translateConstraints == -1 ? std::numeric_limits<uint64>::max() : conf.translateConstraints;
+
+    /// with several threads, the constraints are collected in the order they are translated sequentially
+    std::vector<ReifiedLinearConstraint> todo;
+    unsigned int num = rl.size();
+    for (unsigned int i = 0; i < num;)
+    {
+        if (rl[i].l.productOfDomainsExceptLastLEx(vc,size))
+        {
+            if (conf.translateThreads > 1)
+                todo.emplace_back(std::move(rl[i]));
+            else
+                if (!t.doTranslate(vc,rl[i]))
+                    return false;
+            std::swap(rl[i],*(rl.begin()+num-1));
+            --num;
+        }
+        else
+            ++i;
+    }
+    rl.erase(rl.begin()+num,rl.end());
+    if (todo.empty())
+        return t.flush();
+
+    /// the domain sizes are cached on first use, so compute them before the domains are shared
+    for (std::size_t i = 0; i < vc.numVariables(); ++i)
+        if (vc.isValid(i))
+            vc.getDomain(i).size();
+
+    /// enumerate a window of constraints concurrently, then create the clauses in order,
+    /// this bounds the memory for the stored nogoods
+    const std::size_t window = 1024 * conf.translateThreads;
+    std::vector<TranslatedClauses> out;
+    for (std::size_t begin = 0; begin < todo.size(); begin += window)
+    {
+        std::size_t end = std::min(todo.size(), begin + window);
+        out.clear();
+        out.resize(end - begin);
+        std::atomic<std::size_t> next(begin);
+        auto work = [&]()
+        {
+            for (std::size_t i = next++; i < end; i = next++)
+                t.doTranslate(vc, todo[i], out[i-begin]);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned int i = 1; i < conf.translateThreads && i < end - begin; ++i)
+            workers.emplace_back(work);
+        work();
+        for (auto& w : workers)
+            w.join();
+
+        for (auto& c : out)
+            if (!t.commit(vc, c))
+                return false;
+    }
+    return t.flush();
+}
+
 }
@@ -25,11 +25,14 @@
 #include "clasp/logic_program.h"
 #include "clingcon/clingconorderpropagator.h"
 #include "clingcon/clingcondlpropagator.h"
+#include "clingcon/appsupport.h"
 #include "order/solver.h"
 #include "order/normalizer.h"
 #include "order/configs.h"
 #include <memory>
 #include <sstream>
+#include <set>
+#include <iostream>
 
 
 #include <ctime>
@@ -38,7 +41,7 @@
 
 class ClingconConfig : public Clasp::ClaspConfig {
 public:
-    ClingconConfig(Clasp::SharedContext& c, order::Config conf) : creator_(c), n_(creator_,conf), conf_(conf), cp_(0), s_(0)
+    ClingconConfig(Clasp::SharedContext& c, order::Config conf) : creator_(c), n_(creator_,conf), conf_(conf), cp_(0), dlp_(0), s_(0)
     {
     }
     ~ClingconConfig()
@@ -46,46 +49,40 @@ public:
         if (cp_)
             s_->removePost(cp_);
         delete cp_;
+        if (dlp_)
+            s_->removePost(dlp_);
+        delete dlp_;
     }
 
     virtual bool addPost(Clasp::Solver& s) const
     {
         s_ = &s;
-//        if (conf_.dlprop==2)
-//            if (!addDLProp(s,n_.constraints()))
-//                return false;
-
-//        std::vector<order::ReifiedLinearConstraint> constraints;
-//        if (conf_.dlprop==1)
-//        {
-//            constraints = n_.constraints();
-//        }
+        /// needs the constraints before they are moved to the order propagator
+        if (conf_.dlprop)
+        {
+            dlp_ = new clingcon::ClingconDLPropagator(s, conf_);
+            for (const auto&i : *n_.sharedConstraints())
+            {
+                if (dlp_->isValidConstraint(i))
+                    dlp_->addValidConstraint(i);
+            }
+        }
+        if (conf_.dlprop==1)
+            if (!s.addPost(dlp_))
+                return false;
 
         ///solver takes ownership of propagator
         cp_ = new clingcon::ClingconOrderPropagator(s, n_.getVariableCreator(), conf_,
-                                                                                      std::move(n_.constraints()),n_.getEqualities(),0);
+                                                                                      n_.sharedConstraints(),n_.sharedDistincts(),n_.sharedDisjoints(),n_.getEqualities(),0);
         if (!s.addPost(cp_))
             return false;
 
-//        if (conf_.dlprop==1)
-//            if (!addDLProp(s, constraints))
-//                return false;
+        if (conf_.dlprop==2)
+            if (!s.addPost(dlp_))
+                return false;
         return ClaspConfig::addPost(s);
     }
 
-//    bool addDLProp(Clasp::Solver& s, const std::vector<order::ReifiedLinearConstraint>& constraints) const
-//    {
-//        clingcon::ClingconDLPropagator* dlp = new clingcon::ClingconDLPropagator(s, conf_);
-//        for (const auto&i : constraints)
-//        {
-//            if (dlp->isValidConstraint(i))
-//                dlp->addValidConstraint(i);
-//        }
-//        if (!s.addPost(dlp))
-//            return false;
-//        return true;
-//    }
-
     //clingcon::ClingconPropagator* prop_;///prop_ = new clingcon::ClingconPropagator(new MySolver(&s));
 
     //std::vector<std::unique_ptr<MySolver> > solvers_;
@@ -94,9 +91,49 @@ public:
     mutable order::Normalizer n_;
     order::Config conf_;
     mutable clingcon::ClingconOrderPropagator* cp_;
+    mutable clingcon::ClingconDLPropagator* dlp_;
     mutable Clasp::Solver* s_;
 };
 
+/// creates the propagators through the configurator of the application,
+/// so that several solvers and solve steps can be tested
+class ClingconAppConfig : public Clasp::Cli::ClaspCliConfig {
+public:
+    ClingconAppConfig(Clasp::SharedContext& c, order::Config conf) : creator_(c), n_(creator_,conf), configurator_(conf,n_,to_)
+    {
+        addConfigurator(&configurator_,Clasp::Ownership_t::Type::Retain, false);
+    }
+
+    /// suspends the propagators before the constraints of the next solve step are added, like Helper::postEnd
+    void nextStep(unsigned int numSolvers)
+    {
+        configurator_.suspendProps(numSolvers);
+        to_.props_.resize(numSolvers);
+    }
+
+    MySharedContext creator_;
+    order::Normalizer n_;
+    clingcon::TheoryOutput to_;
+    clingcon::Configurator configurator_;
+};
+
+/// records the values of the shown variables of every model
+class ModelRecorder : public Clasp::EventHandler {
+public:
+    ModelRecorder(const clingcon::TheoryOutput& to) : to_(to) {}
+
+    virtual bool onModel(const Clasp::Solver&, const Clasp::Model& m)
+    {
+        rows_.emplace_back(to_.row(m));
+        defined_.emplace_back(to_.defined(m));
+        return true;
+    }
+
+    const clingcon::TheoryOutput& to_;
+    std::vector<std::vector<int32> > rows_;
+    std::vector<std::vector<bool> > defined_;
+};
+
 
 using namespace order;
 
@@ -1709,6 +1746,18 @@ using namespace order;
             nQueensaux(i);
     }
 
+    TEST_CASE("nQueens propagated disjoint", "1")
+    {
+        /// the disjoint propagator learns its clauses or explains them on demand
+        for (auto i : conf1)
+            for (bool learn : {true, false})
+            {
+                i.disjointProp = true;
+                i.learnClauses = learn;
+                nQueensaux(i);
+            }
+    }
+
 
     void nQueensExaux(order::Config c)
     {
@@ -3083,6 +3132,152 @@ using namespace order;
     }
 
 
+    /// 2 jobs on 2 machines, job 1 uses m1 for 2 and then m2 for 3 steps,
+    /// job 2 uses m2 for 2 and then m1 for 1 step
+    /// returns the number of schedules with makespan <= h
+    uint64 jobShopAux(order::Config c, unsigned int dlprop, int h)
+    {
+        Clasp::ClaspFacade f;
+        auto myconf =  c;
+        myconf.dlprop = dlprop;
+        ClingconConfig conf(f.ctx, myconf);
+        conf.solve.numModels = 0;
+
+        Clasp::Asp::LogicProgram& lp = f.startAsp(conf);
+        REQUIRE(lp.end());
+
+        MySharedContext& solver = conf.creator_;
+
+        View s11 = conf.n_.createView(Domain(0,h-2));
+        View s12 = conf.n_.createView(Domain(0,h-3));
+        View s21 = conf.n_.createView(Domain(0,h-2));
+        View s22 = conf.n_.createView(Domain(0,h-1));
+
+        /// lit -> a + da <= b
+        auto before = [&](View a, int da, View b, order::Literal lit)
+        {
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(a*1);
+            l.add(b*-1);
+            l.addRhs(-da);
+            conf.n_.addConstraint(ReifiedLinearConstraint(std::move(l),lit,Direction::FWD));
+        };
+
+        before(s11,2,s12,solver.trueLit());
+        before(s21,2,s22,solver.trueLit());
+        solver.createNewLiterals(2);
+        order::Literal m1 = solver.getNewLiteral(true);
+        order::Literal m2 = solver.getNewLiteral(true);
+        before(s11,2,s22,m1);
+        before(s22,1,s11,~m1);
+        before(s12,3,s21,m2);
+        before(s21,2,s12,~m2);
+
+        solver.makeRestFalse();
+        REQUIRE(conf.n_.prepare());
+        REQUIRE(conf.n_.finalize());
+        f.prepare();
+        f.solve();
+        return f.summary().numEnum;
+    }
+
+    TEST_CASE("JobShop", "1")
+    {
+        for (auto i : conf1)
+        {
+            uint64 models = jobShopAux(i,0,7);
+            for (unsigned int dlprop = 0; dlprop < 3; ++dlprop)
+            {
+                REQUIRE(jobShopAux(i,dlprop,4)==0);
+                REQUIRE(jobShopAux(i,dlprop,5)==3);
+                REQUIRE(jobShopAux(i,dlprop,7)==models);
+            }
+        }
+    }
+
+    /// jobs x machines job shop, job j visits the machines in the order j, j+1, ...
+    /// all operations on a machine are ordered pairwise by a choice literal
+    /// returns true if a schedule with makespan <= h exists, time is set to the solving time in ms
+    bool jobShopBenchAux(order::Config c, unsigned int dlprop, unsigned int jobs, unsigned int machines, int h, int64& time)
+    {
+        Clasp::ClaspFacade f;
+        auto myconf =  c;
+        myconf.dlprop = dlprop;
+        ClingconConfig conf(f.ctx, myconf);
+        conf.solve.numModels = 1;
+
+        Clasp::Asp::LogicProgram& lp = f.startAsp(conf);
+        REQUIRE(lp.end());
+
+        MySharedContext& solver = conf.creator_;
+
+        auto duration = [](unsigned int j, unsigned int m) { return int((j*7+m*3)%9+1); };
+        /// start time of job j on machine m
+        std::vector<std::vector<View> > start(jobs);
+        for (unsigned int j = 0; j < jobs; ++j)
+            for (unsigned int m = 0; m < machines; ++m)
+                start[j].emplace_back(conf.n_.createView(Domain(0,h-duration(j,m))));
+
+        /// lit -> a + da <= b
+        auto before = [&](View a, int da, View b, order::Literal lit)
+        {
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(a*1);
+            l.add(b*-1);
+            l.addRhs(-da);
+            conf.n_.addConstraint(ReifiedLinearConstraint(std::move(l),lit,Direction::FWD));
+        };
+
+        for (unsigned int j = 0; j < jobs; ++j)
+            for (unsigned int k = 0; k+1 < machines; ++k)
+            {
+                unsigned int m = (j+k)%machines;
+                unsigned int n = (j+k+1)%machines;
+                before(start[j][m],duration(j,m),start[j][n],solver.trueLit());
+            }
+        solver.createNewLiterals(machines*jobs*(jobs-1)/2);
+        for (unsigned int m = 0; m < machines; ++m)
+            for (unsigned int i = 0; i < jobs; ++i)
+                for (unsigned int j = i+1; j < jobs; ++j)
+                {
+                    order::Literal lit = solver.getNewLiteral(true);
+                    before(start[i][m],duration(i,m),start[j][m],lit);
+                    before(start[j][m],duration(j,m),start[i][m],~lit);
+                }
+
+        solver.makeRestFalse();
+        REQUIRE(conf.n_.prepare());
+        REQUIRE(conf.n_.finalize());
+        auto begin = std::chrono::steady_clock::now();
+        f.prepare();
+        f.solve();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-begin).count();
+        return f.summary().numEnum > 0;
+    }
+
+    TEST_CASE("JobShop benchmark", "[.][bench]")
+    {
+        /// run with: test_libclingcon "[bench]"
+        /// compares the order propagator alone with the difference logic propagator before/after it
+        const unsigned int jobs = 8;
+        const unsigned int machines = 6;
+        for (int h : {60, 70, 90})
+        {
+            bool sat = false;
+            for (unsigned int dlprop = 0; dlprop < 3; ++dlprop)
+            {
+                int64 time = 0;
+                bool s = jobShopBenchAux(lazySolveConfigProp4,dlprop,jobs,machines,h,time);
+                if (dlprop == 0)
+                    sat = s;
+                std::cout << jobs << "x" << machines << " job shop, makespan <= " << h << ", difference-logic=" << dlprop
+                          << ": " << (s ? "sat" : "unsat") << " in " << time << "ms" << std::endl;
+                REQUIRE(s==sat);
+            }
+        }
+    }
+
+
 
 
 //    void disjoint0()
@@ -5406,3 +5601,467 @@ using namespace order;
             distinctDom(i);
     }
 
+
+    /// the configurations that propagate the linear constraints instead of translating them
+    std::vector<order::Config> incrementalConfigs()
+    {
+        std::vector<order::Config> ret;
+        for (auto c : {lazySolveConfigProp1, lazySolveConfigProp4, nonlazySolveConfig, lazyExplainSolveConfig, lazySplitSolveConfig})
+        {
+            c.translateConstraints = 0;
+            ret.emplace_back(c);
+        }
+        return ret;
+    }
+
+    TEST_CASE("Incremental order propagator", "1")
+    {
+        /// step 1: l <-> x+y <= 15
+        /// step 2: l gets true on the top level while the propagator is suspended,
+        /// a new variable z and k <-> x-z <= -5 are added,
+        /// the old propagator is extended and replays l
+        for (auto c : incrementalConfigs())
+        {
+            Clasp::ClaspFacade f;
+            ClingconAppConfig conf(f.ctx, c);
+            conf.solve.numModels = 0;
+            Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+            REQUIRE(lp.end());
+            conf.nextStep(1);
+
+            MySharedContext& solver = conf.creator_;
+            View x = conf.n_.createView(Domain(1,10));
+            View y = conf.n_.createView(Domain(1,10));
+            solver.createNewLiterals(1);
+            order::Literal l = solver.getNewLiteral(true);
+            solver.makeRestFalse();
+            {
+                LinearConstraint lc(LinearConstraint::Relation::LE);
+                lc.add(x*1);
+                lc.add(y*1);
+                lc.addRhs(15);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),l,Direction::EQ));
+            }
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            f.solve();
+            REQUIRE(f.summary().numEnum==100);
+            clingcon::ClingconOrderPropagator* p = conf.to_.props_.get(0);
+            REQUIRE(p != nullptr);
+
+            f.update();
+            conf.nextStep(1);
+            REQUIRE(p->suspended());
+            REQUIRE(lp.end());
+            REQUIRE(solver.createClause(LitVec{l}));
+            REQUIRE(f.ctx.master()->propagate());
+
+            View z = conf.n_.createView(Domain(1,10));
+            solver.createNewLiterals(1);
+            order::Literal k = solver.getNewLiteral(true);
+            solver.makeRestFalse();
+            {
+                LinearConstraint lc(LinearConstraint::Relation::LE);
+                lc.add(x*1);
+                lc.add(z*-1);
+                lc.addRhs(-5);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),k,Direction::EQ));
+            }
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            f.solve();
+            /// 85 pairs x+y <= 15, any z
+            REQUIRE(f.summary().numEnum==850);
+            REQUIRE(conf.to_.props_.get(0)==p);
+            REQUIRE(!p->suspended());
+        }
+    }
+
+    TEST_CASE("Incremental helper", "1")
+    {
+        /// the propagator of the first step is extended in the second one
+        Clasp::ClaspFacade f;
+        Clasp::Cli::ClaspCliConfig conf;
+        conf.solve.numModels = 0;
+        order::Config c = lazySolveConfigProp4;
+        Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+        clingcon::Helper h(f.ctx, conf, &lp, c);
+
+        clingcon::ClingconOrderPropagator* first = nullptr;
+        for (unsigned int step = 1; step <= 2; ++step)
+        {
+            Potassco::RuleBuilder rb;
+            rb.start(Potassco::Head_t::Choice).addHead(lp.newAtom()).end();
+            lp.addRule(rb.rule());
+            h.postRead();
+            REQUIRE(h.postEnd());
+            f.prepare();
+            f.solve();
+            REQUIRE(f.summary().numEnum==(step==1 ? 2 : 4));
+            clingcon::ClingconOrderPropagator* p = h.theoryOutput()->props_.get(0);
+            REQUIRE(p != nullptr);
+            REQUIRE(h.postSolve());
+            if (step==1)
+            {
+                first = p;
+                f.update();
+            }
+            else
+                REQUIRE(p == first);
+        }
+    }
+
+    TEST_CASE("Parallel order propagators", "1")
+    {
+        /// two solvers share the order watches of a step,
+        /// in the second step the domain of x changes, so both propagators are destroyed
+        /// and recreated through the watch proxies of their solvers
+        for (auto c : incrementalConfigs())
+        {
+            Clasp::ClaspFacade f;
+            ClingconAppConfig conf(f.ctx, c);
+            conf.solve.numModels = 0;
+            conf.solve.setSolvers(2);
+            Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+            REQUIRE(lp.end());
+            conf.nextStep(2);
+
+            MySharedContext& solver = conf.creator_;
+            View x = conf.n_.createView(Domain(1,10));
+            View y = conf.n_.createView(Domain(1,10));
+            {
+                LinearConstraint lc(LinearConstraint::Relation::LE);
+                lc.add(x*1);
+                lc.add(y*1);
+                lc.addRhs(15);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),solver.trueLit(),Direction::EQ));
+            }
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            f.solve();
+            REQUIRE(f.summary().numEnum==85);
+            REQUIRE(conf.to_.props_.get(0) != nullptr);
+            REQUIRE(conf.to_.props_.get(1) != nullptr);
+
+            f.update();
+            conf.nextStep(2);
+            REQUIRE(lp.end());
+            {
+                LinearConstraint lc(LinearConstraint::Relation::LE);
+                lc.add(x*1);
+                lc.addRhs(5);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),solver.trueLit(),Direction::EQ));
+            }
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            f.solve();
+            /// the stale watches of the old propagators are dropped
+            REQUIRE(f.summary().numEnum==50);
+            for (unsigned int id = 0; id < 2; ++id)
+            {
+                REQUIRE(conf.to_.props_.get(id) != nullptr);
+                REQUIRE(!conf.to_.props_.get(id)->suspended());
+            }
+        }
+    }
+
+    TEST_CASE("Order watch proxy generations", "1")
+    {
+        /// the proxy has to outlive the watches in the solver
+        clingcon::OrderWatchProxy proxy;
+        Clasp::ClaspFacade f;
+        order::Config c = lazySolveConfigProp4;
+        ClingconConfig conf(f.ctx, c);
+        Clasp::Asp::LogicProgram& lp = f.startAsp(conf);
+        REQUIRE(lp.end());
+        View x = conf.n_.createView(Domain(1,10));
+        View y = conf.n_.createView(Domain(1,10));
+        {
+            LinearConstraint lc(LinearConstraint::Relation::LE);
+            lc.add(x*1);
+            lc.add(y*-1);
+            lc.addRhs(0);
+            conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),conf.creator_.trueLit(),Direction::EQ));
+        }
+        REQUIRE(conf.n_.prepare());
+        REQUIRE(conf.n_.finalize());
+        f.prepare();
+
+        Clasp::Solver& s = *f.ctx.master();
+        const auto& vc = conf.n_.getVariableCreator();
+        auto watches = std::make_shared<const clingcon::OrderWatches>(vc, c, conf.n_.sharedConstraints(), conf.n_.sharedDistincts(),
+                                                                      conf.n_.sharedDisjoints(), nullptr, conf.n_.getEqualities());
+        REQUIRE(watches->fits(vc, conf.n_.sharedConstraints(), conf.n_.sharedDistincts(), conf.n_.sharedDisjoints()));
+        auto create = [&]()
+        {
+            return new clingcon::ClingconOrderPropagator(s, vc, c, conf.n_.sharedConstraints(), conf.n_.sharedDistincts(),
+                                                         conf.n_.sharedDisjoints(), conf.n_.getEqualities(), nullptr, nullptr,
+                                                         nullptr, nullptr, &proxy, watches);
+        };
+
+        /// the proxy starts with generation 1, a suspended propagator keeps the watch
+        uint32 first = clingcon::ClingconOrderPropagator::DataBlob(1,true).rep();
+        uint32 second = clingcon::ClingconOrderPropagator::DataBlob(2,true).rep();
+        clingcon::ClingconOrderPropagator* p = create();
+        p->suspend();
+        REQUIRE(proxy.propagate(s, Clasp::posLit(0), first).keepWatch);
+        delete p;
+        /// without a propagator all watches are dropped
+        REQUIRE(!proxy.propagate(s, Clasp::posLit(0), first).keepWatch);
+
+        /// the watches of the first propagator are stale and do not reach the second one
+        p = create();
+        p->suspend();
+        REQUIRE(!proxy.propagate(s, Clasp::posLit(0), first).keepWatch);
+        REQUIRE(proxy.propagate(s, Clasp::posLit(0), second).keepWatch);
+        delete p;
+    }
+
+    TEST_CASE("Split points", "1")
+    {
+        using clingcon::ClingconOrderPropagator;
+        /// 1..10 is split with x<=5 in the middle, x<=1 at the lower and x<=9 at the upper bound
+        REQUIRE(ClingconOrderPropagator::splitPoint(10,0)==4);
+        REQUIRE(ClingconOrderPropagator::splitPoint(10,1)==0);
+        REQUIRE(ClingconOrderPropagator::splitPoint(10,2)==8);
+        REQUIRE(ClingconOrderPropagator::splitPoint(3,0)==1);
+        REQUIRE(ClingconOrderPropagator::splitPoint(3,2)==1);
+        /// two elements are always split between them
+        for (unsigned int h = 0; h <= 2; ++h)
+            REQUIRE(ClingconOrderPropagator::splitPoint(2,h)==0);
+    }
+
+    /// x+y+z <= 12 over 1..10, propagated without order literals
+    std::vector<View> splitProblem(order::Normalizer& n, MySharedContext& solver)
+    {
+        std::vector<View> views;
+        LinearConstraint lc(LinearConstraint::Relation::LE);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            views.emplace_back(n.createView(Domain(1,10)));
+            lc.add(views.back()*1);
+        }
+        lc.addRhs(12);
+        n.addConstraint(ReifiedLinearConstraint(std::move(lc),solver.trueLit(),Direction::EQ));
+        return views;
+    }
+
+    TEST_CASE("Split several variables", "1")
+    {
+        /// isModel splits the n widest undecided variables, on ties the smallest ones, at h
+        for (unsigned int n : {1,2,3,0})
+            for (unsigned int h = 0; h <= 2; ++h)
+            {
+                /// the proxy has to outlive the watches in the solver
+                clingcon::OrderWatchProxy proxy;
+                Clasp::ClaspFacade f;
+                order::Config c = lazySolveConfigProp4;
+                c.translateConstraints = 0;
+                c.minLitsPerVar = 0;
+                c.setSplitVariables(n,h);
+                ClingconConfig conf(f.ctx, c);
+                Clasp::Asp::LogicProgram& lp = f.startAsp(conf);
+                REQUIRE(lp.end());
+                std::vector<View> views = splitProblem(conf.n_, conf.creator_);
+                REQUIRE(conf.n_.prepare());
+                REQUIRE(conf.n_.finalize());
+                f.prepare();
+
+                Clasp::Solver& s = *f.ctx.master();
+                clingcon::ClingconOrderPropagator p(s, conf.n_.getVariableCreator(), c, conf.n_.sharedConstraints(), conf.n_.sharedDistincts(),
+                                                    conf.n_.sharedDisjoints(), conf.n_.getEqualities(), nullptr, nullptr,
+                                                    nullptr, nullptr, &proxy);
+                const auto& vs = p.getVVS().getVariableStorage();
+                std::size_t index = clingcon::ClingconOrderPropagator::splitPoint(10,h);
+                for (const auto& v : views)
+                    REQUIRE(vs.getOrderStorage(v.v).hasNoLiteral(index));
+                REQUIRE(!p.isModel(s));
+                unsigned int num = n==0 ? 3 : n;
+                for (unsigned int i = 0; i < views.size(); ++i)
+                    REQUIRE(vs.getOrderStorage(views[i].v).hasNoLiteral(index) == (i >= num));
+            }
+    }
+
+    TEST_CASE("Split variables models", "1")
+    {
+        /// every split setting finds the same 220 solutions of x+y+z <= 12
+        std::vector<order::Config> configs;
+        for (auto split : std::vector<std::pair<unsigned int,unsigned int> >{{1,0},{1,1},{1,2},{2,0},{4,1},{0,2},{2,2}})
+        {
+            order::Config c = lazySolveConfigProp4;
+            c.minLitsPerVar = 0;
+            configs.emplace_back(c.setSplitVariables(split.first,split.second));
+        }
+        configs.emplace_back(lazySplitSolveConfig);
+        for (auto c : configs)
+        {
+            c.translateConstraints = 0;
+            Clasp::ClaspFacade f;
+            ClingconAppConfig conf(f.ctx, c);
+            conf.solve.numModels = 0;
+            Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+            REQUIRE(lp.end());
+            conf.nextStep(1);
+            std::vector<View> views = splitProblem(conf.n_, conf.creator_);
+            clingcon::NameList names;
+            for (unsigned int i = 0; i < views.size(); ++i)
+                names[views[i].v] = std::make_pair(std::string(1,char('x'+i)), Clasp::LitVec{Clasp::posLit(0)});
+            conf.to_.setNames(std::move(names));
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            ModelRecorder models(conf.to_);
+            f.solve(&models);
+            REQUIRE(f.summary().numEnum==220);
+            REQUIRE(models.rows_.size()==220);
+            for (const auto& row : models.rows_)
+            {
+                REQUIRE(row.size()==3);
+                for (auto value : row)
+                    REQUIRE((value >= 1 && value <= 10));
+                REQUIRE(row[0]+row[1]+row[2] <= 12);
+            }
+            REQUIRE(std::set<std::vector<int32> >(models.rows_.begin(), models.rows_.end()).size()==220);
+        }
+    }
+
+    TEST_CASE("Shown variables without constraints", "1")
+    {
+        /// w is only shown, its value is tracked like the ones of x and y,
+        /// in the second step v is shown as well and the propagator is extended
+        for (auto c : incrementalConfigs())
+        {
+            Clasp::ClaspFacade f;
+            ClingconAppConfig conf(f.ctx, c);
+            conf.solve.numModels = 0;
+            Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+            REQUIRE(lp.end());
+            conf.nextStep(1);
+
+            MySharedContext& solver = conf.creator_;
+            View x = conf.n_.createView(Domain(1,10));
+            View y = conf.n_.createView(Domain(1,10));
+            View w = conf.n_.createView(Domain(1,3));
+            {
+                LinearConstraint lc(LinearConstraint::Relation::LE);
+                lc.add(x*1);
+                lc.add(y*1);
+                lc.addRhs(15);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),solver.trueLit(),Direction::EQ));
+            }
+            clingcon::NameList names;
+            names[x.v] = std::make_pair(std::string("x"), Clasp::LitVec{Clasp::posLit(0)});
+            names[y.v] = std::make_pair(std::string("y"), Clasp::LitVec{Clasp::posLit(0)});
+            names[w.v] = std::make_pair(std::string("w"), Clasp::LitVec{Clasp::posLit(0)});
+            conf.to_.setNames(names);
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            ModelRecorder first(conf.to_);
+            f.solve(&first);
+            REQUIRE(f.summary().numEnum==255);
+            for (const auto& row : first.rows_)
+            {
+                REQUIRE(row.size()==3);
+                REQUIRE(row[0]+row[1] <= 15);
+                REQUIRE((row[2] >= 1 && row[2] <= 3));
+            }
+            REQUIRE(std::set<std::vector<int32> >(first.rows_.begin(), first.rows_.end()).size()==255);
+            clingcon::ClingconOrderPropagator* p = conf.to_.props_.get(0);
+
+            f.update();
+            conf.nextStep(1);
+            REQUIRE(lp.end());
+            View v = conf.n_.createView(Domain(1,2));
+            names[v.v] = std::make_pair(std::string("v"), Clasp::LitVec{Clasp::posLit(0)});
+            conf.to_.setNames(names);
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            ModelRecorder second(conf.to_);
+            f.solve(&second);
+            REQUIRE(f.summary().numEnum==510);
+            REQUIRE(conf.to_.props_.get(0)==p);
+            for (const auto& row : second.rows_)
+            {
+                REQUIRE(row.size()==4);
+                REQUIRE(row[0]+row[1] <= 15);
+                REQUIRE((row[2] >= 1 && row[2] <= 3));
+                REQUIRE((row[3] >= 1 && row[3] <= 2));
+            }
+            REQUIRE(std::set<std::vector<int32> >(second.rows_.begin(), second.rows_.end()).size()==510);
+        }
+    }
+
+    TEST_CASE("Model rows", "1")
+    {
+        /// x = y+1 puts y into the equality class of x, w is only shown if a is true
+        for (auto c : incrementalConfigs())
+        {
+            Clasp::ClaspFacade f;
+            ClingconAppConfig conf(f.ctx, c);
+            conf.solve.numModels = 0;
+            Clasp::Asp::LogicProgram& lp = f.startAsp(conf, true);
+            Potassco::Atom_t a = lp.newAtom();
+            Potassco::RuleBuilder rb;
+            rb.start(Potassco::Head_t::Choice).addHead(a).end();
+            lp.addRule(rb.rule());
+            REQUIRE(lp.end());
+            conf.nextStep(1);
+
+            MySharedContext& solver = conf.creator_;
+            View x = conf.n_.createView(Domain(1,3));
+            View y = conf.n_.createView(Domain(1,3));
+            View w = conf.n_.createView(Domain(1,2));
+            {
+                LinearConstraint lc(LinearConstraint::Relation::EQ);
+                lc.add(x*1);
+                lc.add(y*-1);
+                lc.addRhs(1);
+                conf.n_.addConstraint(ReifiedLinearConstraint(std::move(lc),solver.trueLit(),Direction::EQ));
+            }
+            clingcon::NameList names;
+            names[x.v] = std::make_pair(std::string("x"), Clasp::LitVec{Clasp::posLit(0)});
+            names[y.v] = std::make_pair(std::string("y"), Clasp::LitVec{Clasp::posLit(0)});
+            names[w.v] = std::make_pair(std::string("w"), Clasp::LitVec{lp.getLiteral(a)});
+            conf.to_.setNames(names);
+            REQUIRE(conf.to_.columns()==(std::vector<order::Variable>{x.v,y.v,w.v}));
+            REQUIRE(conf.to_.columnNames()==(std::vector<std::string>{"x","y","w"}));
+            REQUIRE(conf.n_.prepare());
+            REQUIRE(conf.n_.finalize());
+            f.prepare();
+            ModelRecorder models(conf.to_);
+            f.solve(&models);
+            /// 2 pairs of x and y, times 2 values of w, with a or without
+            REQUIRE(f.summary().numEnum==8);
+            REQUIRE(models.rows_.size()==8);
+            std::set<std::vector<int32> > shown;
+            for (unsigned int i = 0; i != models.rows_.size(); ++i)
+            {
+                const auto& row = models.rows_[i];
+                const auto& defined = models.defined_[i];
+                REQUIRE(row.size()==3);
+                REQUIRE(defined.size()==3);
+                REQUIRE(defined[0]);
+                REQUIRE(defined[1]);
+                REQUIRE(row[0]==row[1]+1);
+                if (defined[2])
+                {
+                    REQUIRE((row[2] >= 1 && row[2] <= 2));
+                    shown.insert(row);
+                }
+            }
+            REQUIRE(shown.size()==4);
+
+            /// columns outside of the table are never shown
+            clingcon::ClingconOrderPropagator* p = conf.to_.props_.get(0);
+            REQUIRE(p != nullptr);
+            int32 value;
+            REQUIRE(p->printModel(3,"z")==nullptr);
+            REQUIRE(!p->getValue(3,value));
+        }
+    }
@@ -17,296 +17,218 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 // }}}
-
-//#include <cppunit/extensions/HelperMacros.h>
-//#include "clasp/clasp_facade.h"
-//#include "clasp/solver.h"
-//#include "clasp/cli/clasp_output.h"
-//#include "order/dlpropagator.h"
-//#include <memory>
-//#include <sstream>
-//#include <unordered_set>
-
-
-
-
-//class DiffLogicTest : public CppUnit::TestFixture
-//{
-//    CPPUNIT_TEST_SUITE( DiffLogicTest );
-//    CPPUNIT_TEST( testGraphActivate );
-
-//    CPPUNIT_TEST_SUITE_END();
-//private:
-//public:
-//    void setUp()
-//    {
-//    }
-
-//    void tearDown()
-//    {
-//    }
-
-
-//    bool test(const difflogic::DLPropagator& g, const std::vector<difflogic::DLPropagator::EdgeId>& all, const std::unordered_set<difflogic::DLPropagator::EdgeId>& active) const
-//    {
-//        for (const auto&i : all)
-//        {
-//            auto opp = -i;
-//            if (active.count(i))
-//            {
-//                if (!g.isTrue(i))
-//                    return false;
-//                if (!g.isFalse(opp))
-//                    return false;
-//            }
-//            else
-//                if (active.count(opp))
-//                {
-//                    if (!g.isTrue(opp))
-//                        return false;
-//                    if (!g.isFalse(i))
-//                        return false;
-//                }
-//                else
-//                {
-//                    if (!g.isUnknown(i))
-//                        return false;
-//                }
-//        }
-//        return true;
-//    }
-
-
-
-//    void testGraphActivate()
-//    {
-
-//        {
-//        using namespace difflogic;
-//        DLPropagator g;
-
-//        DLPropagator::Variable x = g.newVar();
-//        DLPropagator::Variable y = g.newVar();
-//        DLPropagator::Variable z = g.newVar();
-//        DLPropagator::Variable w = g.newVar();
-
-//        /// this is a cycle free graph
-//        std::vector<DLPropagator::EdgeId> edges;
-//        std::unordered_set<DLPropagator::EdgeId> active;
-
-
-//        edges.emplace_back(g.addEdge(y,4,w));//1
-//        edges.emplace_back(g.addEdge(w,2,z));//2
-//        edges.emplace_back(g.addEdge(z,-3,y));//3
-//        edges.emplace_back(g.addEdge(y,5,z));//4
-//        edges.emplace_back(g.addEdge(z,-7,x));//5
-//        edges.emplace_back(g.addEdge(x,3,y));//6
-//        edges.emplace_back(g.addEdge(x,6,w));//7
-
-////        for (const auto& i : edges)
-////            g.addEdge(i.in,i.weight,i.out);
-
-
-//        g.activate(1/*y,4,w*/);
-//        active.emplace(1);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        g.activate(2/*w,2,z*/);
-//        active.emplace(2);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        g.activate(5/*z,-7,x*/);
-//        active.emplace(5);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-
-//        g.activate(3/*z,-3,y*/);
-//        active.emplace(3);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-
-//        g.activate(4/*y,5,z*/);
-//        active.emplace(4);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        g.activate(6/*x,3,y*/);
-//        active.emplace(6);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        g.activate(7/*x,6,w*/);
-//        active.emplace(7);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        CPPUNIT_ASSERT(g.getPotential(x)==-7);
-//        CPPUNIT_ASSERT(g.getPotential(y)==-4);
-//        CPPUNIT_ASSERT(g.getPotential(z)==0);
-//        CPPUNIT_ASSERT(g.getPotential(w)==-1);
-//        }
-
-//        {
-//        using namespace difflogic;
-//        DLPropagator g;
-
-//        DLPropagator::Variable start = g.newVar();
-//        DLPropagator::Variable a = g.newVar();
-//        DLPropagator::Variable b = g.newVar();
-//        DLPropagator::Variable c = g.newVar();
-//        DLPropagator::Variable finish = g.newVar();
-
-//        std::vector<DLPropagator::EdgeId> edges;
-//        std::unordered_set<DLPropagator::EdgeId> active;
-
-
-//        edges.emplace_back(g.addEdge(start,1,a));  //1
-//        edges.emplace_back(g.addEdge(a,-2,b));     //2
-//        edges.emplace_back(g.addEdge(b,-3,c));     //3
-//        edges.emplace_back(g.addEdge(c,4,a));      //4
-//        edges.emplace_back(g.addEdge(c,3,start));  //5
-//        edges.emplace_back(g.addEdge(c,-2,finish));//6
-
-
-
-//        g.activate(1);
-//        active.emplace(1);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        g.activate(2);
-//        active.emplace(2);
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-
-//        g.activate(3);
-//        active.emplace((3));
-//        active.emplace((-4));
-//        active.emplace((-5));
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        CPPUNIT_ASSERT(g.reason((-5))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2), (1)}));
-//        CPPUNIT_ASSERT(g.reason((-4))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2)}));
-
-//        g.activate(6);
-//        active.emplace((6));
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        CPPUNIT_ASSERT(g.reason((-5))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2), (1)}));
-//        CPPUNIT_ASSERT(g.reason((-4))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2)}));
-
-//        g.undo();
-//        active.erase((6));
-
-//        CPPUNIT_ASSERT(g.reason((-5))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2), (1)}));
-//        CPPUNIT_ASSERT(g.reason((-4))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2)}));
-
-//        g.activate(-6);
-//        active.emplace((-6));
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-//        CPPUNIT_ASSERT(g.reason((-5))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2), (1)}));
-//        CPPUNIT_ASSERT(g.reason((-4))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2)}));
-
-//        g.undo();
-//        active.erase((-6));
-
-//        CPPUNIT_ASSERT(g.reason((-5))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2), (1)}));
-//        CPPUNIT_ASSERT(g.reason((-4))==(std::vector<difflogic::DLPropagator::EdgeId>{(3), (2)}));
-
-//        g.undo();
-//        active.erase((3));
-//        active.erase((-4));
-//        active.erase((-5));
-//        CPPUNIT_ASSERT(test(g,edges,active));
-
-
-//        }
-
-//        {
-//        difflogic::DLPropagator g;
-
-//        difflogic::DLPropagator::Variable x = g.newVar();
-//        difflogic::DLPropagator::Variable y = g.newVar();
-//        difflogic::DLPropagator::Variable z = g.newVar();
-//        difflogic::DLPropagator::Variable w = g.newVar();
-//        g.addEdge(y,4,w);
-//        g.addEdge(w,2,z);
-//        g.addEdge(z,-3,y);
-//        g.addEdge(y,5,z);
-//        g.addEdge(z,-7,x);
-//        g.addEdge(x,3,y);
-//        g.addEdge(x,6,w);
-
-
-//        g.activate(1);
-//        g.activate(2);
-//        g.activate(3);
-//        g.activate(4);
-//        g.activate(5);
-//        g.activate(6);
-//        g.activate(7);
-
-
-
-
-
-
-
-
-//        CPPUNIT_ASSERT(g.getPotential(x)==-7);
-//        CPPUNIT_ASSERT(g.getPotential(y)==-4);
-//        CPPUNIT_ASSERT(g.getPotential(z)==0);
-//        CPPUNIT_ASSERT(g.getPotential(w)==-1);
-//        }
-
-//        {
-//        difflogic::DLPropagator g;
-
-//        difflogic::DLPropagator::Variable x = g.newVar();
-//        difflogic::DLPropagator::Variable y = g.newVar();
-//        difflogic::DLPropagator::Variable z = g.newVar();
-//        difflogic::DLPropagator::Variable w = g.newVar();
-//        g.addEdge(y,4,w);//1
-//        g.addEdge(w,2,z);//2
-//        g.addEdge(z,-3,y);//3
-//        g.addEdge(y,5,z);//4
-//        g.addEdge(z,-7,x);//5
-//        g.addEdge(x,3,y);//6
-//        g.addEdge(x,6,w);//7
-
-
-//        g.activate(4);
-//        g.activate(5);
-//        g.activate(3);
-//        g.activate(2);
-//        g.activate(1);
-//        g.activate(6);
-//        g.activate(7);
-
-
-
-
-//        CPPUNIT_ASSERT(g.getPotential(x)==-7);
-//        CPPUNIT_ASSERT(g.getPotential(y)==-4);
-//        CPPUNIT_ASSERT(g.getPotential(z)==0);
-//        CPPUNIT_ASSERT(g.getPotential(w)==-1);
-//        }
-
-
-
-
-//        /*TODO: unit test for graph, example from bellman ford wiki
-
-//                GOAL: we want to compute the shortest distance to a virtual q, this is our potential function
-//                Then we want to activate edges and update the potential function to do a dijkstra and to find all implications
-
-//                Computing reasons could be troublesome, as we do not have the potential function anymore (in some cases)! because we backtracked
-//                WARNING, computing reasons is not always on the decisionlevel of p
-
-//                */
-
-//        CPPUNIT_ASSERT(true);
-
-//    }
-
-
-//};
-
-//CPPUNIT_TEST_SUITE_REGISTRATION (DiffLogicTest);
+#include "catch.hpp"
+#include "order/dlpropagator.h"
+#include <unordered_set>
+#include <vector>
+
+using namespace difflogic;
+
+namespace
+{
+    /// edges in active are true, edges whose negation is in active are false
+    /// all other edges are unknown
+    bool test(const DLPropagator& g, const std::vector<DLPropagator::EdgeId>& all, const std::unordered_set<DLPropagator::EdgeId>& active)
+    {
+        for (const auto&i : all)
+        {
+            if (active.count(i))
+            {
+                if (!g.isTrue(i))
+                    return false;
+            }
+            else
+                if (active.count(-i))
+                {
+                    if (!g.isFalse(i))
+                        return false;
+                }
+                else
+                {
+                    if (!g.isUnknown(i))
+                        return false;
+                }
+        }
+        return !g.hasNegativeCycle();
+    }
+}
+
+    TEST_CASE("DL graph activate", "[difflogic]")
+    {
+        DLPropagator g;
+
+        DLPropagator::Variable x = g.newVar();
+        DLPropagator::Variable y = g.newVar();
+        DLPropagator::Variable z = g.newVar();
+        DLPropagator::Variable w = g.newVar();
+
+        /// this is a cycle free graph
+        std::vector<DLPropagator::EdgeId> edges;
+        std::unordered_set<DLPropagator::EdgeId> active;
+
+        edges.emplace_back(g.addEdge(y,4,w));//1
+        edges.emplace_back(g.addEdge(w,2,z));//2
+        edges.emplace_back(g.addEdge(z,-3,y));//3
+        edges.emplace_back(g.addEdge(y,5,z));//4
+        edges.emplace_back(g.addEdge(z,-7,x));//5
+        edges.emplace_back(g.addEdge(x,3,y));//6
+        edges.emplace_back(g.addEdge(x,6,w));//7
+
+        for (auto i : {1,2,5,3,4,6,7})
+        {
+            REQUIRE(g.activate(i).empty());
+            active.emplace(i);
+            REQUIRE(test(g,edges,active));
+        }
+
+        REQUIRE(g.getPotential(x)==-7);
+        REQUIRE(g.getPotential(y)==-4);
+        REQUIRE(g.getPotential(z)==0);
+        REQUIRE(g.getPotential(w)==-1);
+    }
+
+    TEST_CASE("DL graph activation order", "[difflogic]")
+    {
+        DLPropagator g;
+
+        DLPropagator::Variable x = g.newVar();
+        DLPropagator::Variable y = g.newVar();
+        DLPropagator::Variable z = g.newVar();
+        DLPropagator::Variable w = g.newVar();
+        g.addEdge(y,4,w);//1
+        g.addEdge(w,2,z);//2
+        g.addEdge(z,-3,y);//3
+        g.addEdge(y,5,z);//4
+        g.addEdge(z,-7,x);//5
+        g.addEdge(x,3,y);//6
+        g.addEdge(x,6,w);//7
+
+        for (auto i : {4,5,3,2,1,6,7})
+            g.activate(i);
+
+        REQUIRE(g.getPotential(x)==-7);
+        REQUIRE(g.getPotential(y)==-4);
+        REQUIRE(g.getPotential(z)==0);
+        REQUIRE(g.getPotential(w)==-1);
+
+        for (unsigned int i = 0; i < 7; ++i)
+            g.undo();
+        for (auto i : {1,2,3,4,5,6,7})
+            REQUIRE(g.isUnknown(i));
+        REQUIRE(g.getPotential(x)==0);
+        REQUIRE(g.getPotential(y)==0);
+        REQUIRE(g.getPotential(z)==0);
+        REQUIRE(g.getPotential(w)==0);
+    }
+
+    TEST_CASE("DL graph undo first activation", "[difflogic]")
+    {
+        DLPropagator g;
+
+        DLPropagator::Variable x = g.newVar();
+        DLPropagator::Variable y = g.newVar();
+        DLPropagator::EdgeId e1 = g.addEdge(x,-2,y);
+        DLPropagator::EdgeId e2 = g.addEdge(y,1,x);
+
+        /// the oldest activation has no separator in front of it
+        REQUIRE(g.activate(e1).size()==1);
+        REQUIRE(g.isFalse(e2));
+        g.undo();
+        REQUIRE(g.isUnknown(e1));
+        REQUIRE(g.isUnknown(e2));
+        REQUIRE(g.getPotential(x)==0);
+        REQUIRE(g.getPotential(y)==0);
+
+        /// the graph can be used again afterwards
+        REQUIRE(g.activate(e2).size()==1);
+        REQUIRE(g.isFalse(e1));
+        g.undo();
+        REQUIRE(g.isUnknown(e1));
+        REQUIRE(g.isUnknown(e2));
+    }
+
+    TEST_CASE("DL graph propagation and reasons", "[difflogic]")
+    {
+        DLPropagator g;
+
+        DLPropagator::Variable start = g.newVar();
+        DLPropagator::Variable a = g.newVar();
+        DLPropagator::Variable b = g.newVar();
+        DLPropagator::Variable c = g.newVar();
+        DLPropagator::Variable finish = g.newVar();
+
+        std::vector<DLPropagator::EdgeId> edges;
+        std::unordered_set<DLPropagator::EdgeId> active;
+
+        edges.emplace_back(g.addEdge(start,1,a));  //1
+        edges.emplace_back(g.addEdge(a,-2,b));     //2
+        edges.emplace_back(g.addEdge(b,-3,c));     //3
+        edges.emplace_back(g.addEdge(c,4,a));      //4
+        edges.emplace_back(g.addEdge(c,3,start));  //5
+        edges.emplace_back(g.addEdge(c,-2,finish));//6
+
+        g.activate(1);
+        active.emplace(1);
+        REQUIRE(test(g,edges,active));
+
+        g.activate(2);
+        active.emplace(2);
+        REQUIRE(test(g,edges,active));
+
+        auto conseq = g.activate(3);
+        REQUIRE(std::unordered_set<DLPropagator::EdgeId>(conseq.begin(), conseq.end())==(std::unordered_set<DLPropagator::EdgeId>{-4,-5}));
+        active.emplace(3);
+        active.emplace(-4);
+        active.emplace(-5);
+        REQUIRE(test(g,edges,active));
+
+        REQUIRE(g.reason(-5)==(std::vector<DLPropagator::EdgeId>{3, 2, 1}));
+        REQUIRE(g.reason(-4)==(std::vector<DLPropagator::EdgeId>{3, 2}));
+
+        g.activate(6);
+        active.emplace(6);
+        REQUIRE(test(g,edges,active));
+
+        REQUIRE(g.reason(-5)==(std::vector<DLPropagator::EdgeId>{3, 2, 1}));
+        REQUIRE(g.reason(-4)==(std::vector<DLPropagator::EdgeId>{3, 2}));
+
+        g.undo();
+        active.erase(6);
+        REQUIRE(test(g,edges,active));
+
+        REQUIRE(g.reason(-5)==(std::vector<DLPropagator::EdgeId>{3, 2, 1}));
+        REQUIRE(g.reason(-4)==(std::vector<DLPropagator::EdgeId>{3, 2}));
+
+        g.undo();
+        active.erase(3);
+        active.erase(-4);
+        active.erase(-5);
+        REQUIRE(test(g,edges,active));
+    }
+
+    TEST_CASE("DL graph false edges stay inactive", "[difflogic]")
+    {
+        DLPropagator g;
+
+        DLPropagator::Variable x = g.newVar();
+        DLPropagator::Variable y = g.newVar();
+
+        /// x-y <= -1, y-x <= 0, y-x <= 1
+        DLPropagator::EdgeId e1 = g.addEdge(x,-1,y);
+        DLPropagator::EdgeId e2 = g.addEdge(y,0,x);
+        DLPropagator::EdgeId e3 = g.addEdge(y,1,x);
+
+        REQUIRE(g.activate(e1)==(std::vector<DLPropagator::EdgeId>{-e2}));
+        REQUIRE(g.isFalse(e2));
+        REQUIRE(g.isUnknown(e3));
+        REQUIRE(g.reason(-e2)==(std::vector<DLPropagator::EdgeId>{e1}));
+        /// the opposite of a false edge is not asserted, so e3 can still be added
+        REQUIRE(g.activate(e3).empty());
+        REQUIRE(g.isTrue(e3));
+        REQUIRE(!g.hasNegativeCycle());
+        g.undo();
+        g.undo();
+        REQUIRE(g.isUnknown(e1));
+        REQUIRE(g.isUnknown(e2));
+        REQUIRE(g.isUnknown(e3));
+    }
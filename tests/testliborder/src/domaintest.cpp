@@ -22,6 +22,7 @@
 #include "order/domain.h"
 #include "order/config.h"
 #include <iostream>
+#include <chrono>
 
 using namespace order;
 
@@ -257,3 +258,141 @@ using namespace order;
 
     }
 
+
+    TEST_CASE("Domain progressions", "[sets]")
+    {
+        /// multiplication keeps one range per range
+        Domain d(0,1000000);
+        d.inplace_times(3, -1);
+        REQUIRE(d.getRanges().size()==1);
+        REQUIRE(d.getRanges().front()==Range(0,3000000,3));
+        REQUIRE(d.size()==1000001);
+        REQUIRE(d.in(2999997));
+        REQUIRE(!d.in(2999998));
+        REQUIRE(*(d.begin()+1000)==3000);
+        REQUIRE(*(std::lower_bound(d.begin(), d.end(), 301))==303);
+
+        /// division only keeps the multiples
+        Domain e(d);
+        e.inplace_divide(2);
+        REQUIRE(e.getRanges().front()==Range(0,1500000,3));
+        e.inplace_divide(3);
+        REQUIRE(e==Domain(0,500000));
+
+        /// 4*i+2 = 0 mod 6 <=> i = 1 mod 3
+        Domain f(-10,100);
+        REQUIRE(f.constrainDomain(4,2,6));
+        REQUIRE(f.getRanges().front()==Range(-8,100,3));
+        REQUIRE(!f.constrainDomain(2,1,4));
+        REQUIRE(f.empty());
+
+        Domain g(0,20);
+        g.inplace_times(2, -1);
+        REQUIRE(g.intersect(5,30));
+        REQUIRE(g.getRanges().front()==Range(6,30,2));
+        REQUIRE(g.remove(10));
+        REQUIRE(g.size()==12);
+        Domain h(0,10);
+        h.inplace_times(3,-1);
+        REQUIRE(g.intersect(h));
+        Domain expected(6,6);
+        expected.unify(12,12);
+        expected.unify(18,18);
+        expected.unify(24,24);
+        expected.unify(30,30);
+        REQUIRE(g==expected);
+
+        /// interleaving progressions are unified
+        Domain i(0,10);
+        i.inplace_times(2,-1);
+        Domain j(0,9);
+        j.inplace_times(2,-1);
+        j+=1;
+        i.unify(j);
+        REQUIRE(i==Domain(0,20));
+        Domain k(0,4);
+        k.inplace_times(5,-1);
+        Domain l(0,2);
+        REQUIRE((k+l).size()==15);
+
+        /// the stride of a two element range can get as large as the range
+        Domain m(0,1);
+        m.inplace_times(1000000000,-1);
+        REQUIRE(m.getRanges().front()==Range(0,1000000000,1000000000));
+        REQUIRE(m.size()==2);
+
+        /// view domains of multiplied variables
+        ViewDomain v(Domain(1,1000000),View(0,-7,3));
+        REQUIRE(v.size()==1000000);
+        REQUIRE(v.lower()==-6999997);
+        REQUIRE(v.in(-4));
+        REQUIRE(!v.in(-5));
+    }
+
+    TEST_CASE("SmallVector", "[sets]")
+    {
+        SmallVector<Range,2> v{Range(0,1)};
+        REQUIRE(v.isInline());
+        v.emplace_back(5,9,2);
+        REQUIRE(v.isInline());
+        v.insert(v.begin()+1, Range(3,3));
+        REQUIRE(!v.isInline());
+        REQUIRE(v.size()==3);
+        REQUIRE(v[1]==Range(3,3));
+        REQUIRE(v.back()==Range(5,9,2));
+
+        SmallVector<Range,2> w(v);
+        REQUIRE(w==v);
+        w.erase(w.begin(), w.begin()+2);
+        REQUIRE(w.size()==1);
+        REQUIRE(w.front()==Range(5,9,2));
+
+        SmallVector<Range,2> x(std::move(v));
+        REQUIRE(v.empty());
+        REQUIRE(v.isInline());
+        REQUIRE(x.size()==3);
+        x.swap(w);
+        REQUIRE(x.size()==1);
+        REQUIRE(w.size()==3);
+        std::vector<Range> more{Range(20,21),Range(30,30)};
+        x.insert(x.end(), more.begin(), more.end());
+        REQUIRE(x.size()==3);
+        REQUIRE(x[2]==Range(30,30));
+
+        /// single interval domains do not allocate
+        Domain d(0,100);
+        Domain e(d);
+        REQUIRE(e.getRanges().isInline());
+        e.remove(50);
+        REQUIRE(e.getRanges().isInline());
+        e.remove(20);
+        REQUIRE(!e.getRanges().isInline());
+        REQUIRE(e.size()==99);
+    }
+
+    TEST_CASE("Domain benchmark", "[.][bench]")
+    {
+        /// run with: test_liborder "[bench]"
+        const int rounds = 1000000;
+        Domain base(-1000,1000);
+        uint64 inlined = 0;
+        uint64 check = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i)
+        {
+            Domain d(base);
+            d.intersect(-500+i%100,500);
+            d.remove(500);
+            d.unify(400+i%200,600);
+            d += i%7;
+            Domain e(d);
+            e.intersect(d);
+            inlined += d.getRanges().isInline() + e.getRanges().isInline();
+            check += e.size();
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "intersect/remove/unify/add on " << rounds << " domains: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << "ms, "
+                  << inlined << " of " << 2*rounds << " copies without heap allocation (" << check << ")" << std::endl;
+        REQUIRE(inlined==2*(uint64)rounds);
+    }
@@ -27,6 +27,24 @@
 
 using namespace order;
 
+namespace
+{
+/// an incremental solver that only knows the true literal
+class MyIncrementalSolver : public IncrementalSolver
+{
+public:
+    MyIncrementalSolver() : lits_(2) {}
+    bool isTrue(Literal l) const { return l==trueLit(); }
+    bool isFalse(Literal l) const { return l==falseLit(); }
+    bool isUnknown(Literal l) const { return (l!=trueLit() && l != falseLit()); }
+    Literal getNewLiteral() { return Literal(lits_++,false); }
+    Literal trueLit() const { return Literal(1, false); }
+    Literal falseLit() const { return ~trueLit(); }
+private:
+    unsigned int lits_;
+};
+}
+
 
 
     TEST_CASE("TestUnique", "[linearPropagator]")
@@ -421,3 +439,345 @@ using namespace order;
         REQUIRE(n.getVariableCreator().getViewDomain(v3).upper()==-3);
     }
 
+
+    TEST_CASE("TestPropagation4", "[linearPropagator]")
+    {
+
+        MySolver s;
+        Normalizer n(s, translateConfig);
+
+
+        View x = n.createView(Domain(0,10));
+        View y = n.createView(Domain(0,10));
+        View z = n.createView(Domain(0,10));
+
+        /// 2x + 3y - z <= 4
+        LinearConstraint l(LinearConstraint::Relation::LE);
+        l.add(x*2);
+        l.add(y*3);
+        l.add(z*-1);
+        l.addRhs(4);
+        n.addConstraint(ReifiedLinearConstraint(std::move(l),s.trueLit(),Direction::EQ));
+
+        /// z - x <= 1, each new bound of x wakes up the first constraint again
+        LinearConstraint l2(LinearConstraint::Relation::LE);
+        l2.add(z);
+        l2.add(x*-1);
+        l2.addRhs(1);
+        n.addConstraint(ReifiedLinearConstraint(std::move(l2),s.trueLit(),Direction::EQ));
+        n.prepare();
+
+        REQUIRE(n.getVariableCreator().getViewDomain(x).upper()==5);
+        REQUIRE(n.getVariableCreator().getViewDomain(y).upper()==3);
+        REQUIRE(n.getVariableCreator().getViewDomain(z).upper()==6);
+    }
+
+    TEST_CASE("TestReifiedWakeup", "[linearPropagator]")
+    {
+
+        MySolver s;
+        VariableCreator vc(s, translateConfig);
+        Variable x = vc.createVariable(Domain(0,10));
+        Variable y = vc.createVariable(Domain(0,10));
+        Variable z = vc.createVariable(Domain(0,10));
+        vc.prepareOrderLitMemory();
+        Literal b = s.getNewLiteral(true);
+
+        LinearPropagator p(s, vc, translateConfig);
+
+        /// x - z <= -5
+        LinearConstraint l(LinearConstraint::Relation::LE);
+        l.add(View(x));
+        l.add(View(z,-1));
+        l.addRhs(-5);
+        p.addImp(ReifiedLinearConstraint(std::move(l),s.trueLit(),Direction::FWD));
+
+        /// b -> z + y <= 4, only gets violated after the lower bound of z was increased
+        LinearConstraint l2(LinearConstraint::Relation::LE);
+        l2.add(View(z));
+        l2.add(View(y));
+        l2.addRhs(4);
+        p.addImp(ReifiedLinearConstraint(std::move(l2),b,Direction::FWD));
+
+        REQUIRE(p.propagate());
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(z).lower()==5);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(x).upper()==5);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(y).upper()==10);
+        REQUIRE(p.propagated());
+        REQUIRE(std::find(s.clauses().begin(), s.clauses().end(), ~b) != s.clauses().end());
+
+        /// the undecided constraint is checked first and again after it was woken up
+        REQUIRE(p.stats().wakeups[0]==2);
+        REQUIRE(p.stats().wakeups[2]==1);
+
+        /// the statistics of several propagators are summed up for the output
+        QueueStats sum;
+        sum += p.stats();
+        sum += p.stats();
+        REQUIRE(sum.wakeups[0]==4);
+        REQUIRE(sum.wakeups[2]==2);
+        REQUIRE(sum.emptyWakeups[1]==0);
+    }
+
+    TEST_CASE("TestIncrementalDomainChange", "[linearPropagator]")
+    {
+        MySolver s;
+        VariableCreator vc(s, translateConfig);
+        Variable x = vc.createVariable(Domain(0,10));
+        Variable y = vc.createVariable(Domain(0,10));
+        Variable z = vc.createVariable(Domain(0,10));
+        Variable w = vc.createVariable(Domain(0,10));
+        vc.prepareOrderLitMemory();
+
+        LinearPropagator p(s, vc, translateConfig);
+
+        /// x + y <= 10
+        LinearConstraint l(LinearConstraint::Relation::LE);
+        l.add(View(x));
+        l.add(View(y));
+        l.addRhs(10);
+        p.addImp(ReifiedLinearConstraint(std::move(l),s.trueLit(),Direction::FWD));
+
+        /// y - z <= 0
+        LinearConstraint l2(LinearConstraint::Relation::LE);
+        l2.add(View(y));
+        l2.add(View(z,-1));
+        l2.addRhs(0);
+        p.addImp(ReifiedLinearConstraint(std::move(l2),s.trueLit(),Direction::FWD));
+
+        /// w <= 5
+        LinearConstraint l3(LinearConstraint::Relation::LE);
+        l3.add(View(w));
+        l3.addRhs(5);
+        p.addImp(ReifiedLinearConstraint(std::move(l3),s.trueLit(),Direction::FWD));
+
+        auto wakeups = [&p]() { uint64 sum = 0; for (auto i : p.stats().wakeups) sum += i; return sum; };
+        auto writeBack = [&p,&vc]()
+        {
+            for (Variable i = 0; i < vc.numVariables(); ++i)
+            {
+                const auto& r = p.getVariableStorage().getCurrentRestrictor(i);
+                if (!vc.constrainView(View(i), r.lower(), r.upper()))
+                    return false;
+            }
+            return true;
+        };
+
+        REQUIRE(p.domainsChanged());
+        REQUIRE(p.propagate());
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(w).upper()==5);
+        REQUIRE(writeBack());
+        REQUIRE(vc.getDomain(w).upper()==5);
+
+        /// the domains are changed in place, x gets a hole
+        REQUIRE(vc.constrainView(View(x), 8, 10));
+        REQUIRE(vc.removeFromView(View(x), 9));
+        REQUIRE(vc.constrainView(View(z), 0, 3));
+        auto before = wakeups();
+        REQUIRE(p.domainsChanged());
+        REQUIRE(p.propagate());
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(x).lower()==8);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(x).size()==2);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(y).upper()==2);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(z).upper()==3);
+        REQUIRE(p.getVariableStorage().getCurrentRestrictor(w).upper()==5);
+        /// w <= 5 is not touched again
+        REQUIRE(wakeups()-before<=3);
+        REQUIRE(writeBack());
+        REQUIRE(vc.getDomain(y).upper()==2);
+
+        /// nothing changed, nothing to do
+        before = wakeups();
+        REQUIRE(p.domainsChanged());
+        REQUIRE(p.propagate());
+        REQUIRE(wakeups()==before);
+        REQUIRE(!p.propagated());
+    }
+
+    TEST_CASE("TestDistinctPropagator", "[linearPropagator]")
+    {
+        MySolver s;
+        Config conf = lazySolveConfigProp4;
+        conf.alldistinctProp = true;
+        Normalizer n(s, conf);
+
+        View x = n.createView(Domain(1,2));
+        View y = n.createView(Domain(1,2));
+        View z = n.createView(Domain(1,4));
+        n.addConstraint(ReifiedAllDistinct({x,y,z},s.trueLit(),Direction::EQ));
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        /// no pairwise inequalities
+        REQUIRE(n.constraints().size()==0);
+        REQUIRE(n.sharedDistincts()->size()==1);
+
+        MyIncrementalSolver is;
+        LinearLiteralPropagator p(is, n.getVariableCreator(), conf);
+        p.addDistincts(n.sharedDistincts());
+        std::vector<LinearLiteralPropagator::LinearConstraintClause> clauses;
+        while (!p.atFixPoint())
+        {
+            auto& c = p.propagateSingleStep();
+            clauses.insert(clauses.end(), c.begin(), c.end());
+        }
+        /// x and y take 1 and 2, so z > 2
+        auto& vs = p.getVVS().getVariableStorage();
+        REQUIRE(vs.getCurrentRestrictor(z).lower()==3);
+        REQUIRE(vs.getCurrentRestrictor(z).upper()==4);
+        REQUIRE(p.propagatedDistinct());
+        REQUIRE(clauses.size()==1);
+        REQUIRE(clauses[0].first==s.falseLit());
+        /// bounds of x and y, z >= 1 and the consequence not -z >= -2
+        REQUIRE(clauses[0].second.size()==6);
+        REQUIRE(clauses[0].second.back().view()==z*-1);
+        REQUIRE(*clauses[0].second.back()==-2);
+
+        /// z <= 2 leaves three views for two values
+        p.addLevel();
+        REQUIRE(!p.constrainUpperBound(vs.getRestrictor(z).begin()+2));
+        p.removeLevel();
+        p.addLevel();
+        REQUIRE(p.constrainUpperBound(vs.getRestrictor(x).begin()+1));
+        clauses.clear();
+        while (!p.atFixPoint())
+        {
+            auto& c = p.propagateSingleStep();
+            clauses.insert(clauses.end(), c.begin(), c.end());
+        }
+        /// x = 1 -> y = 2
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==2);
+        REQUIRE(vs.getCurrentRestrictor(z).lower()==3);
+        REQUIRE(clauses.size()==1);
+        p.removeLevel();
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==1);
+    }
+
+    TEST_CASE("TestDisjointPropagator", "[linearPropagator]")
+    {
+        MySolver s;
+        Config conf = lazySolveConfigProp4;
+        conf.disjoint2distinct = false;
+        conf.disjointProp = true;
+        Normalizer n(s, conf);
+
+        View x = n.createView(Domain(3,4));
+        View y = n.createView(Domain(3,5));
+        View z = n.createView(Domain(3,4));
+        Literal c = s.getNewLiteral(true);
+        {
+            std::vector<std::vector<std::pair<View,ReifiedDNF>>> vars(2);
+            vars[0].emplace_back(x,ReifiedDNF(std::vector<LitVec>{LitVec()}));
+            vars[1].emplace_back(y,ReifiedDNF(std::vector<LitVec>{LitVec()}));
+            vars[1].emplace_back(z,ReifiedDNF(std::vector<LitVec>{LitVec{c}}));
+            n.addConstraint(ReifiedDisjoint(std::move(vars),s.trueLit(),Direction::EQ));
+        }
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        REQUIRE(n.constraints().size()==0);
+        REQUIRE(n.sharedDisjoints()->size()==1);
+
+        MyIncrementalSolver is;
+        LinearLiteralPropagator p(is, n.getVariableCreator(), conf);
+        p.addDisjoints(n.sharedDisjoints());
+        auto propagate = [&p]()
+        {
+            std::vector<std::pair<LinearLiteralPropagator::LinearConstraintClause,LitVec> > clauses;
+            while (!p.atFixPoint())
+            {
+                auto& c = p.propagateSingleStep();
+                for (std::size_t i = 0; i < c.size(); ++i)
+                    clauses.emplace_back(c[i],p.clauseConditions(i));
+            }
+            return clauses;
+        };
+        auto& vs = p.getVVS().getVariableStorage();
+        REQUIRE(propagate().size()==0);
+
+        /// x = 3 -> y > 3
+        p.addLevel();
+        REQUIRE(p.constrainUpperBound(vs.getRestrictor(x).begin()+1));
+        auto clauses = propagate();
+        REQUIRE(p.propagatedDisjoint());
+        REQUIRE(clauses.size()==1);
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==4);
+        REQUIRE(vs.getCurrentRestrictor(z).size()==2);
+        REQUIRE(clauses[0].second.size()==2);
+
+        /// x = 3 and z = 3 -> not c
+        p.addLevel();
+        REQUIRE(p.constrainUpperBound(vs.getRestrictor(z).begin()+1));
+        clauses = propagate();
+        REQUIRE(clauses.size()==1);
+        REQUIRE(std::find(clauses[0].second.begin(), clauses[0].second.end(), ~c) != clauses[0].second.end());
+        REQUIRE(clauses[0].first.second.size()==4);
+        p.removeLevel();
+        p.removeLevel();
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==3);
+    }
+
+    TEST_CASE("Extend propagator incrementally", "[linearPropagator]")
+    {
+        MySolver s;
+        Config conf = lazySolveConfigProp4;
+        conf.translateConstraints = 0;
+        Normalizer n(s, conf);
+
+        View x = n.createView(Domain(1,10));
+        View y = n.createView(Domain(1,10));
+        Literal a = s.getNewLiteral(true);
+        {
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(x);
+            l.add(y);
+            l.addRhs(12);
+            n.addConstraint(ReifiedLinearConstraint(std::move(l),a,Direction::FWD));
+        }
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        REQUIRE(n.sharedConstraints()->size()==1);
+        auto distincts = n.sharedDistincts();
+
+        MyIncrementalSolver is;
+        LinearLiteralPropagator p(is, n.getVariableCreator(), conf);
+        p.addImp(n.sharedConstraints());
+        while (!p.atFixPoint())
+            p.propagateSingleStep();
+
+        /// next step with a new variable, the domains of the old ones do not change
+        View z = n.createView(Domain(1,10));
+        {
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(x);
+            l.add(z*-1);
+            n.addConstraint(ReifiedLinearConstraint(std::move(l),s.trueLit(),Direction::FWD));
+        }
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        /// the implication of the first step is kept in front
+        REQUIRE(n.sharedConstraints()->size()==2);
+        REQUIRE((*n.sharedConstraints())[0].v==a);
+        REQUIRE((*n.sharedConstraints())[1].v==s.trueLit());
+        REQUIRE(n.constraints().size()==2);
+        REQUIRE(n.constraintEpoch()==0);
+        REQUIRE(n.sharedDistincts()==distincts);
+        REQUIRE(n.getVariableCreator().getDomain(x.v)==Domain(1,10));
+
+        p.getVVS().extend(n.getVariableCreator());
+        p.extendImp(n.sharedConstraints());
+        REQUIRE(p.constraints().size()==2);
+        auto& vs = p.getVVS().getVariableStorage();
+        REQUIRE(vs.numVariables()==n.getVariableCreator().numVariables());
+        while (!p.atFixPoint())
+            p.propagateSingleStep();
+
+        /// z <= 3 -> x <= 3
+        p.addLevel();
+        REQUIRE(p.constrainUpperBound(vs.getRestrictor(z).begin()+3));
+        std::size_t propagations = 0;
+        while (!p.atFixPoint())
+            propagations += p.propagateSingleStep().size();
+        REQUIRE(propagations==1);
+        REQUIRE(vs.getCurrentRestrictor(x).upper()==3);
+        p.removeLevel();
+        REQUIRE(vs.getCurrentRestrictor(x).upper()==10);
+    }
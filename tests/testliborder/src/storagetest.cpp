@@ -19,3 +19,365 @@
 // }}}
 
 
+#include "catch.hpp"
+#include "order/storage.h"
+#include "order/normalizer.h"
+#include "order/configs.h"
+#include "test/mysolver.h"
+
+using namespace order;
+
+    TEST_CASE("VariableStorage levels", "[storage]")
+    {
+        MySolver s;
+        VariableCreator vc(s, translateConfig);
+        Variable x = vc.createVariable(Domain(1,10));
+        Variable y = vc.createVariable(Domain(-5,5));
+        vc.prepareOrderLitMemory();
+        VariableStorage vs(vc, s.trueLit());
+
+        auto rx = vs.getRestrictor(View(x));
+        auto ry = vs.getRestrictor(View(y));
+
+        vs.addLevel();
+        REQUIRE(vs.constrainUpperBound(rx.begin()+8)); // x <= 8
+        REQUIRE(vs.getCurrentRestrictor(x).upper()==8);
+
+        vs.addLevel();
+        REQUIRE(vs.constrainLowerBound(rx.begin()+2)); // x >= 3
+        REQUIRE(vs.constrainUpperBound(rx.begin()+5)); // x <= 5
+        REQUIRE(vs.constrainLowerBound(ry.begin()+5)); // y >= 0
+        REQUIRE(vs.getCurrentRestrictor(x).lower()==3);
+        REQUIRE(vs.getCurrentRestrictor(x).upper()==5);
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==0);
+
+        /// reversed views restrict the other bound of the variable
+        REQUIRE(vs.constrainUpperBound(vs.getRestrictor(View(y,-1)).begin()+3)); // -y <= -3
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==3);
+        REQUIRE(vs.getCurrentRestrictor(View(y,-1)).upper()==-3);
+        REQUIRE(!vs.constrainUpperBound(rx.begin()+2)); // x <= 2, empty
+
+        vs.removeLevel();
+        REQUIRE(vs.getCurrentRestrictor(x).lower()==1);
+        REQUIRE(vs.getCurrentRestrictor(x).upper()==8);
+        REQUIRE(vs.getCurrentRestrictor(y).lower()==-5);
+        REQUIRE(vs.getCurrentRestrictor(y).upper()==5);
+
+        vs.addLevel();
+        REQUIRE(vs.constrainUpperBound(ry.begin()+1)); // y <= -5
+        REQUIRE(vs.getCurrentRestrictor(y).size()==1);
+        vs.removeLevel();
+        vs.removeLevel();
+        REQUIRE(vs.getCurrentRestrictor(x).size()==10);
+        REQUIRE(vs.getCurrentRestrictor(y).size()==11);
+    }
+
+    TEST_CASE("LazyLiteralRegistry marks", "[storage]")
+    {
+        LazyLiteralRegistry r;
+        r.reset(3);
+        REQUIRE(r.numVariables()==3);
+        REQUIRE(r.count(0,5)==0);
+        REQUIRE(r.mark(0,5)==1);
+        REQUIRE(r.mark(0,5)==2);
+        REQUIRE(r.mark(0,1000)==1);
+        REQUIRE(r.mark(2,0)==1);
+        REQUIRE(r.count(0,5)==2);
+        REQUIRE(r.count(0,6)==0);
+        REQUIRE(r.count(1,5)==0);
+
+        std::vector<std::pair<unsigned int,unsigned int> > seen;
+        r.forEach(0, [&](unsigned int index, unsigned int count) { seen.emplace_back(index,count); });
+        std::sort(seen.begin(),seen.end());
+        REQUIRE(seen.size()==2);
+        REQUIRE(seen[0]==std::make_pair(5u,2u));
+        REQUIRE(seen[1]==std::make_pair(1000u,1u));
+
+        r.reset(3);
+        REQUIRE(r.count(0,5)==0);
+        REQUIRE(r.count(2,0)==0);
+    }
+
+    TEST_CASE("Convert lazy literals", "[storage]")
+    {
+        for (bool unite : {true, false})
+        {
+            MySolver s;
+            Config conf = lazySolveConfigProp2;
+            conf.convertLazy = std::make_pair(2,unite);
+            Normalizer n(s,conf);
+            View x = n.createView(Domain(1,100000));
+            REQUIRE(n.prepare());
+            REQUIRE(n.finalize());
+            auto& vc = n.getVariableCreator();
+            auto begin = vc.getRestrictor(x).begin();
+            REQUIRE(!vc.hasLELiteral(begin+50001));
+            REQUIRE(!vc.hasLELiteral(begin+50003));
+
+            /// both threads created x<=50002, only one created x<=50004
+            n.lazyLiterals().mark(x.v,50001);
+            n.lazyLiterals().mark(x.v,50001);
+            n.lazyLiterals().mark(x.v,50003);
+            n.convertLazyLiterals(2);
+
+            REQUIRE(vc.hasLELiteral(begin+50001));
+            REQUIRE(vc.hasLELiteral(begin+50003)==unite);
+            REQUIRE(n.lazyLiterals().count(x.v,50001)==0);
+        }
+    }
+
+    TEST_CASE("LazyLiteralRegistry pool", "[storage]")
+    {
+        LazyLiteralRegistry r;
+        r.reset(2);
+        Literal l(0,false);
+        REQUIRE(!r.share(0,5,l));
+        r.setPool(LitVec{Literal(10,false),Literal(11,false)});
+        REQUIRE(r.poolSize()==2);
+
+        /// every thread gets the same literal for the same bound
+        REQUIRE(r.share(0,5,l));
+        REQUIRE(l==Literal(10,false));
+        REQUIRE(r.share(0,5,l));
+        REQUIRE(l==Literal(10,false));
+        REQUIRE(r.share(1,1000,l));
+        REQUIRE(l==Literal(11,false));
+        REQUIRE(!r.share(0,6,l));
+
+        Variable var;
+        unsigned int index;
+        REQUIRE(r.poolBound(0,var,index));
+        REQUIRE(var==0);
+        REQUIRE(index==5);
+        REQUIRE(r.poolBound(1,var,index));
+        REQUIRE(var==1);
+        REQUIRE(index==1000);
+
+        /// an unused pool literal is closed and can no longer be taken
+        r.setPool(LitVec{Literal(12,false)});
+        REQUIRE(!r.poolBound(0,var,index));
+        REQUIRE(!r.share(0,7,l));
+        r.reset(2);
+        REQUIRE(r.poolSize()==0);
+    }
+
+    TEST_CASE("Convert shared lazy literals", "[storage]")
+    {
+        MySolver s;
+        Config conf = lazySolveConfigProp2;
+        conf.setSharedLazyLiterals(2);
+        Normalizer n(s,conf);
+        View x = n.createView(Domain(1,100000));
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        auto& vc = n.getVariableCreator();
+        auto begin = vc.getRestrictor(x).begin();
+        REQUIRE(n.lazyLiterals().poolSize()==2);
+        Literal unused = n.lazyLiterals().poolLiteral(1);
+
+        Literal l(0,false);
+        REQUIRE(n.lazyLiterals().share(x.v,50001,l));
+        REQUIRE(l==n.lazyLiterals().poolLiteral(0));
+        REQUIRE(!vc.hasLELiteral(begin+50001));
+        REQUIRE(n.convertLazyLiterals(0));
+
+        /// the shared literal becomes the order literal, the unused one is made false
+        REQUIRE(vc.hasLELiteral(begin+50001));
+        REQUIRE(vc.getLELiteral(begin+50001)==l);
+        LitVec unit{~unused, Literal::fromRep(0)};
+        REQUIRE(std::search(s.clauses().begin(), s.clauses().end(), unit.begin(), unit.end())!=s.clauses().end());
+        REQUIRE(n.lazyLiterals().poolSize()==0);
+    }
+
+    TEST_CASE("Translate hot constraints", "[storage]")
+    {
+        MySolver s;
+        Config conf = lazySolveConfigProp2;
+        conf.translateConstraints = 0;
+        conf.setTranslateHot(30,2);
+        Normalizer n(s,conf);
+        View x = n.createView(Domain(1,20));
+        View y = n.createView(Domain(1,20));
+        LitVec lits;
+        for (int rhs : {10, 15, 20})
+        {
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(x);
+            l.add(y);
+            l.addRhs(rhs);
+            lits.emplace_back(s.getNewLiteral(true));
+            n.addConstraint(ReifiedLinearConstraint(std::move(l),lits.back(),Direction::FWD));
+        }
+        REQUIRE(n.prepare());
+        REQUIRE(n.finalize());
+        REQUIRE(n.sharedConstraints()->size()==3);
+        REQUIRE(n.constraintActivity().size()==3);
+
+        auto index = [&](Literal v)
+        {
+            const auto& c = *n.sharedConstraints();
+            return std::find_if(c.begin(),c.end(),[&](const ReifiedLinearConstraint& i){ return i.v==v; })-c.begin();
+        };
+        /// the second constraint is the most active one and is translated,
+        /// the first one is also active enough but does not fit into the remaining budget,
+        /// the third one is not active enough
+        for (unsigned int i = 0; i < 2; ++i)
+            n.constraintActivity().mark(index(lits[0]));
+        for (unsigned int i = 0; i < 5; ++i)
+            n.constraintActivity().mark(index(lits[1]));
+        n.constraintActivity().mark(index(lits[2]));
+        std::size_t clauses = s.clauses().size();
+        REQUIRE(n.translateHotConstraints());
+
+        REQUIRE(s.clauses().size()>clauses);
+        REQUIRE(n.sharedConstraints()->size()==2);
+        REQUIRE(index(lits[0])<2);
+        REQUIRE(index(lits[1])==2);
+        REQUIRE(index(lits[2])<2);
+        REQUIRE(n.constraintActivity().size()==2);
+        REQUIRE(n.constraintActivity().count(0)==0);
+
+        /// without activity nothing changes
+        REQUIRE(n.translateHotConstraints());
+        REQUIRE(n.sharedConstraints()->size()==2);
+    }
+
+    TEST_CASE("ClauseBuffer", "[storage]")
+    {
+        MySolver s;
+        Literal a = s.getNewLiteral(true);
+        Literal b = s.getNewLiteral(true);
+        Literal c = s.getNewLiteral(true);
+        {
+            ClauseBuffer clauses(s, 8);
+            REQUIRE(clauses.add({a,b}));
+            REQUIRE(clauses.add({~a,c}));
+            REQUIRE(s.clauses().empty());
+            /// the third clause fills the buffer
+            REQUIRE(clauses.add(LitVec{~b,~c,a}));
+            REQUIRE(s.clauses().size()==10);
+            REQUIRE(clauses.add({c}));
+            REQUIRE(s.clauses().size()==10);
+            REQUIRE(clauses.flush());
+        }
+        MySolver s2;
+        s2.getNewLiteral(true);
+        s2.getNewLiteral(true);
+        s2.getNewLiteral(true);
+        REQUIRE(s2.createClause({a,b}));
+        REQUIRE(s2.createClause({~a,c}));
+        REQUIRE(s2.createClause({~b,~c,a}));
+        REQUIRE(s2.createClause({c}));
+        REQUIRE(s.clauses()==s2.clauses());
+    }
+
+    TEST_CASE("SparseLitMap", "[storage]")
+    {
+        SparseLitMap m;
+        REQUIRE(m.empty());
+        REQUIRE(m.lower_bound(5)==m.end());
+        REQUIRE(m.find(5)==m.end());
+
+        /// insert in an order that splits several chunks
+        std::vector<unsigned int> indices;
+        for (unsigned int i = 0; i < 2000; ++i)
+            indices.push_back((i*7919)%2000*3);
+        for (auto i : indices)
+        {
+            auto r = m.emplace(i, Literal(i+1,false));
+            REQUIRE(r.second);
+            REQUIRE(r.first->first==i);
+        }
+        REQUIRE(m.size()==2000);
+        REQUIRE_FALSE(m.emplace(300, Literal(1,true)).second);
+        REQUIRE(m.find(300)->second==Literal(301,false));
+
+        unsigned int expected = 0;
+        for (const auto& i : m)
+        {
+            REQUIRE(i.first==expected);
+            REQUIRE(i.second==Literal(expected+1,false));
+            expected += 3;
+        }
+        REQUIRE(expected==6000);
+
+        auto it = m.lower_bound(1000);
+        REQUIRE(it->first==1002);
+        --it;
+        REQUIRE(it->first==999);
+        REQUIRE(m.find(1000)==m.end());
+        REQUIRE(m.lower_bound(6000)==m.end());
+        it = m.end();
+        --it;
+        REQUIRE(it->first==5997);
+
+        /// erase every second entry
+        it = m.begin();
+        while (it != m.end())
+        {
+            it = m.erase(it);
+            if (it != m.end())
+                ++it;
+        }
+        REQUIRE(m.size()==1000);
+        expected = 3;
+        for (const auto& i : m)
+        {
+            REQUIRE(i.first==expected);
+            expected += 6;
+        }
+        while (!m.empty())
+            m.erase(m.begin());
+        REQUIRE(m.begin()==m.end());
+
+        /// the map is replaced by the vector once it is dense
+        orderStorage s;
+        s.useMap();
+        s.setSize(16);
+        s.setLiteral(15, Literal(1,false));
+        s.setLiteral(3, Literal(2,false));
+        REQUIRE(s.hasMap());
+        REQUIRE(s.numLits()==2);
+        for (unsigned int i = 4; i < 15 && s.hasMap(); ++i)
+            s.setLiteral(i, Literal(i,false));
+        REQUIRE_FALSE(s.hasMap());
+        REQUIRE(s.hasVector());
+        REQUIRE(s.getLiteral(3)==Literal(2,false));
+        REQUIRE(s.getLiteral(15)==Literal(1,false));
+        REQUIRE(s.hasNoLiteral(0));
+    }
+
+    TEST_CASE("Incremental equality literals", "[storage]")
+    {
+        MySolver s;
+        VariableCreator vc(s, translateConfig);
+        Variable x = vc.createVariable(Domain(1,10));
+        Variable y = vc.createVariable(Domain(1,10));
+        vc.prepareOrderLitMemory();
+        auto rx = vc.getRestrictor(View(x));
+
+        Literal x7 = vc.getEqualLit(View(x),7);
+        REQUIRE(vc.setEqualLit(rx.begin()+4, s.falseLit())); // x != 5
+        Literal y3 = vc.getEqualLit(View(y),3);
+        REQUIRE(vc.numEqualLits()==3);
+        REQUIRE(vc.getEqualLit(View(x),7)==x7);
+
+        REQUIRE(vc.createEqualClauses());
+        std::size_t clauses = s.clauses().size();
+        REQUIRE(clauses>0);
+        /// nothing new, no new clauses
+        REQUIRE(vc.createEqualClauses());
+        REQUIRE(s.clauses().size()==clauses);
+
+        REQUIRE(vc.restrictDomainsAccordingToLiterals());
+        REQUIRE(vc.numEqualLits()==2);
+        REQUIRE(vc.getDomainSize(View(x))==9);
+        REQUIRE(vc.getEqualLit(View(y),3)==y3);
+
+        REQUIRE(vc.setEqualLit(vc.getRestrictor(View(y)).begin()+5, s.trueLit())); // y == 6
+        REQUIRE(vc.restrictDomainsAccordingToLiterals());
+        REQUIRE(vc.getDomainSize(View(y))==1);
+        REQUIRE(vc.getRestrictor(View(y)).lower()==6);
+        /// y==3 is still undecided in the solver
+        REQUIRE(vc.numEqualLits()==2);
+    }
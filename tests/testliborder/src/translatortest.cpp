@@ -106,10 +106,10 @@ bool compareClauses(const LitVec& l1, const LitVec& l2)
 }
 
 
-order::Config test1 = order::Config(false,10000,false,{3,1024},false,false,false,false,true,true,0,-1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
-order::Config test2 = order::Config(true,100,false,{0,10000},false,false,false,false,true,true,0,-1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
-order::Config test3 = order::Config(true,100,false,{1000,10000},false,false,false,false,true,true,0,-1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
-order::Config test4 = order::Config(true,100,false,{3,1024},false,false,false,false,false,true,0,-1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
+order::Config test1 = order::Config(false,10000,false,{3,1024},false,false,false,false,false,false,true,true,0,-1,1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
+order::Config test2 = order::Config(true,100,false,{0,10000},false,false,false,false,false,false,true,true,0,-1,1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
+order::Config test3 = order::Config(true,100,false,{1000,10000},false,false,false,false,false,false,true,true,0,-1,1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),false);
+order::Config test4 = order::Config(true,100,false,{3,1024},false,false,false,false,false,false,false,true,0,-1,1,-1,true,true, false,true,false, 4,true,std::make_pair(64,true),true);
 std::vector<order::Config> stdconfs = {translateConfig,test1,test2};
 
 ///break symm
@@ -2484,6 +2484,79 @@ std::vector<order::Config> stdconfs = {translateConfig,test1,test2};
                     }*/
     }
 
+    TEST_CASE("domainStrided", "translatortest")
+    {
+        /// l <-> x in {6,9,12}, the bounds suffice if x only takes multiples of 3
+        for (bool strided : {true, false})
+        {
+            MySolver solver;
+            Normalizer norm(solver, translateConfig);
+            Domain dom(0,10);
+            if (strided)
+                dom.inplace_times(3,-1);
+            else
+                dom = Domain(0,30);
+            View x = norm.createView(dom);
+            Domain d(2,4);
+            d.inplace_times(3,-1);
+            REQUIRE(d.getRanges().front()==Range(6,12,3));
+            norm.addConstraint(ReifiedDomainConstraint(x,std::move(d),solver.getNewLiteral(true),Direction::EQ));
+            REQUIRE(norm.prepare());
+            REQUIRE(norm.finalize());
+            REQUIRE(expectedModels(solver)==(strided ? 11 : 31));
+        }
+    }
+
+    TEST_CASE("parallelTranslate", "translatortest")
+    {
+        /// x+y+z <= 12, x-y <= 3, 2x+3z >= 10, y != z
+        auto build = [](MySolver& s, const Config& conf)
+        {
+            Normalizer norm(s, conf);
+            View x = norm.createView(Domain(0,9));
+            View y = norm.createView(Domain(0,9));
+            View z = norm.createView(Domain(0,9));
+
+            LinearConstraint l(LinearConstraint::Relation::LE);
+            l.add(x);
+            l.add(y);
+            l.add(z);
+            l.addRhs(12);
+            norm.addConstraint(ReifiedLinearConstraint(std::move(l),s.trueLit(),Direction::EQ));
+
+            LinearConstraint l2(LinearConstraint::Relation::LE);
+            l2.add(x);
+            l2.add(y*-1);
+            l2.addRhs(3);
+            norm.addConstraint(ReifiedLinearConstraint(std::move(l2),s.trueLit(),Direction::EQ));
+
+            LinearConstraint l3(LinearConstraint::Relation::GE);
+            l3.add(x*2);
+            l3.add(z*3);
+            l3.addRhs(10);
+            norm.addConstraint(ReifiedLinearConstraint(std::move(l3),s.trueLit(),Direction::EQ));
+
+            LinearConstraint l4(LinearConstraint::Relation::NE);
+            l4.add(y);
+            l4.add(z*-1);
+            norm.addConstraint(ReifiedLinearConstraint(std::move(l4),s.trueLit(),Direction::EQ));
+
+            REQUIRE(norm.prepare());
+            REQUIRE(norm.finalize());
+        };
+
+        MySolver s1;
+        build(s1, translateConfig);
+        MySolver s2;
+        build(s2, parallelTranslateConfig);
+        MySolver s3;
+        build(s3, parallelTranslateConfig);
+
+        /// the clauses are created in the same order regardless of the scheduling
+        REQUIRE(s2.clauses()==s3.clauses());
+        REQUIRE(expectedModels(s1)==expectedModels(s2));
+    }
+
     TEST_CASE("testAllDiffSplitting", "translatortest")
     {
 